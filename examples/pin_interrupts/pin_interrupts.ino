@@ -4,20 +4,28 @@ void handle_keypad(void);
 void handle_left_button(void);
 void handle_right_button(void);
 
-#define DEBOUNCE_THRESHOLD 20
+#define LOCKOUT_MS 20
 
 // using triggers for human-scale events, such as pressing buttons, is probably
 // better handled with polling, but for this demonstration, the only certain
 // inputs are from the keypad, pushbuttons, and slide switches. Because those
-// mechanical devices will bounce, let's make sure there's only one interrupt
-// fired per press/release/toggle.
+// mechanical devices will bounce, each pin is locked out for a while after its
+// handler runs, so there's only one interrupt fired per press/release/toggle.
+// If the pin is in a different position when the lockout ends, the handler is
+// run again for that change.
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+#define debounce_interrupt(action) do { action; } while(0)
+#else
+// lockouts are available only on the Uno and Nano, so other boards ignore the
+// interrupts that follow too closely after the previous one
 #define debounce_interrupt(action)                            \
   do {                                                        \
     static unsigned long last_trigger = 0L;                   \
     unsigned long now = millis();                             \
-    if (now - last_trigger > DEBOUNCE_THRESHOLD) { action; }  \
+    if (now - last_trigger > LOCKOUT_MS) { action; }          \
     last_trigger = now;                                       \
   } while(0)
+#endif
 
 static volatile char last_key;
 static volatile uint8_t last_left_button;
@@ -33,53 +41,59 @@ void setup() {
     last_left_button = cowpi_left_button_is_pressed();
     last_right_button = cowpi_right_button_is_pressed();
     // demonstrates multiple pins using the same handler
-    cowpi_register_pin_ISR((1L << 14) | (1L << 15) | (1L << 16) | (1L << 17), handle_keypad);
+    cowpi_register_pin_ISR(COWPI_PIN_SET(14) | COWPI_PIN_SET(15) | COWPI_PIN_SET(16) | COWPI_PIN_SET(17), handle_keypad);
     // demonstrates different pins on the same I/O bank (for ATmega328P) using different handlers
-    cowpi_register_pin_ISR(1L << 8, handle_left_button);
-    cowpi_register_pin_ISR(1L << 9, handle_right_button);
+    cowpi_register_pin_ISR(COWPI_PIN_SET(8), handle_left_button);
+    cowpi_register_pin_ISR(COWPI_PIN_SET(9), handle_right_button);
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+    cowpi_set_pin_ISR_lockout(COWPI_PIN_SET(14) | COWPI_PIN_SET(15) | COWPI_PIN_SET(16) | COWPI_PIN_SET(17)
+                              | COWPI_PIN_SET(8) | COWPI_PIN_SET(9), LOCKOUT_MS);
+#endif
 }
 
 void loop() {
-    ;
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+    // the bounces that the lockouts kept from reaching the handlers
+    static uint16_t last_dropped = 0;
+    uint16_t dropped = cowpi_get_dropped_pin_events(8) + cowpi_get_dropped_pin_events(9);
+    if (dropped != last_dropped) {
+        printf("buttons bounced %u times\n", dropped);
+        last_dropped = dropped;
+    }
+#endif
 }
 
 void handle_keypad(void) {
     debounce_interrupt({
-        char key;
-        // When scanning the keypad to figure out which key was pressed, it's possible that the key bounced, and we
-        // see the key in its previous (unpressed) position. Similarly, on a key release, a bounce would make us see
-        // the key as pressed. So we'll just keep scanning the keypad until we see something different from what we
-        // saw before (something *must* be different, or there wouldn't have been an interrupt).
-        // busy-wait through the race condition
-        while ((key = cowpi_get_keypress()) == last_key) {}
-
-        // you *really* shouldn't print in an ISR! but this is for demonstration purposes
-        printf("keypad: %#4x\n", cowpi_get_keypress());
-
-        last_key = key;
+        // Scanning the keypad toggles the column pins, but the column that changed is locked out, and another column
+        // changes only if one of its keys is also pressed.
+        char key = cowpi_get_keypress();
+        if (key != last_key) {
+            // you *really* shouldn't print in an ISR! but this is for demonstration purposes
+            printf("keypad: %#4x\n", key);
+            last_key = key;
+        }
     });
 }
 
 void handle_left_button(void) {
     debounce_interrupt({
-        uint8_t this_position;
-        // busy-wait through the race condition
-        while ((this_position = cowpi_left_button_is_pressed()) == last_left_button) {}
-
-        printf("left button is %s\n", this_position? "pressed" : "released");
-
-        last_left_button = this_position;
+        uint8_t this_position = cowpi_left_button_is_pressed();
+        if (this_position != last_left_button) {
+            printf("left button is %s\n", this_position? "pressed" : "released");
+            last_left_button = this_position;
+        }
     });
 }
 
 void handle_right_button(void) {
     debounce_interrupt({
-        // since the new position MUST be the opposite of the old position, we could simply invert `last_right_button`
-        // instead of reading the button's position
-        uint8_t this_position = !last_right_button;
-
-        printf("right button is %s\n", this_position? "down" : "up");
-
-        last_right_button = this_position;
+        // a bounce that gets past the debouncing would leave an inverted `last_right_button` in the wrong position, so
+        // the button's position is read instead
+        uint8_t this_position = cowpi_right_button_is_pressed();
+        if (this_position != last_right_button) {
+            printf("right button is %s\n", this_position? "down" : "up");
+            last_right_button = this_position;
+        }
     });
 }
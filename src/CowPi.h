@@ -85,9 +85,14 @@
 #include <CowPi_stdio.h>
 #include "setup/cowpi_setup.h"
 #include "boards/boards.h"
+#include "boards/registers.h"
 #include "interrupts/pin_interrupts.h"
+#include "interrupts/timer_interrupts.h"
 #include "io/cowpi_io.h"
+#include "io/pins.h"
 #include "io/debounce.h"
+#include "io/keypad.h"
+#include "io/inputs.h"
 
 #define COWPI_VERSION ("0.8.2")
 
@@ -0,0 +1,208 @@
+/**************************************************************************//**
+ *
+ * @file atmega2560.h
+ *
+ * @author Christopher A. Bohn
+ *
+ * @brief Type definitions and constants for the ATmega2560 microcontroller
+ *      (Arduino Mega 2560)
+ *
+ * This header provides the base address for memory-mapped I/O and
+ * data structures to conveniently access the I/O registers.
+ *
+ * Possibly-useful memory-mapped registers:
+ * | Use                                            | Datatype              | Memory Address                    |
+ * |:----------------------------------------------:|:----------------------|:----------------------------------|
+ * | External pins (ports A-G)                      | cowpi_ioport_t[7]     | 0x20 (use COWPI_IOPORT())         |
+ * | External pins (ports H-L)                      | cowpi_ioport_t[5]     | 0x100 (use COWPI_IOPORT())        |
+ * | Pin-based interrupts                           | cowpi_pininterrupt_t  | 0x3B                              |
+ * | SPI protocol                                   | cowpi_spi_t           | 0x4C                              |
+ * | I2C protocol                                   | cowpi_i2c_t           | 0xB8                              |
+ * | Timer0                                         | cowpi_timer8bit_t     | 0x44                              |
+ * | Timer1                                         | cowpi_timer16bit_t    | 0x80                              |
+ * | Timer2                                         | cowpi_timer8bit_t     | 0xB0                              |
+ * | Timer3                                         | cowpi_timer16bit_t    | 0x90                              |
+ * | Timer4                                         | cowpi_timer16bit_t    | 0xA0                              |
+ * | Timer5                                         | cowpi_timer16bit_t    | 0x120                             |
+ * | Timer interrupt masks (TIMSKx)                 | uint8_t[6]            | 0x6E (index with timer number)    |
+ * | Timer interrupt flags (TIFRx)                  | uint8_t[6]            | 0x35 (index with timer number)    |
+ * | General timer/counter control register (GTCCR) | uint8_t               | 0x43                              |
+ * | Asynchronous Status Register (ASSR)            | uint8_t               | 0xB6                              |
+ *
+ * Unlike the ATmega328P, the Arduino Mega 2560's pin numbers do not follow the
+ * order of the I/O ports' bits; use `COWPI_PIN_PORT()` and `COWPI_PIN_MASK()`
+ * to find a pin's port and bit.
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COWPI_ATMEGA2560_H
+#define COWPI_ATMEGA2560_H
+
+#ifdef __AVR_ATmega2560__
+
+#define COWPI_USING_A_SUPPORTED_BOARD
+
+#include <Arduino.h>
+#include <stdint.h>
+
+
+#define COWPI_IO_BASE ((uint8_t *) (0x20))  //!< Base address of the memory-mapped I/O registers
+
+
+#define COWPI_PA  0                 //!< Port number for PINA/DDRA/PORTA (pins D22-D29)
+#define COWPI_PB  1                 //!< Port number for PINB/DDRB/PORTB and PCMSK0 (pins D10-D13, D50-D53)
+#define COWPI_PC  2                 //!< Port number for PINC/DDRC/PORTC (pins D30-D37)
+#define COWPI_PD  3                 //!< Port number for PIND/DDRD/PORTD (pins D18-D21, D38)
+#define COWPI_PE  4                 //!< Port number for PINE/DDRE/PORTE (pins D0-D3, D5)
+#define COWPI_PF  5                 //!< Port number for PINF/DDRF/PORTF (pins D54-D61, aka A0-A7)
+#define A0_A7     5                 //!< Alias of COWPI_PF corresponding to pins D54-D61 (A0-A7) on the Arduino Mega 2560
+#define COWPI_PG  6                 //!< Port number for PING/DDRG/PORTG (pins D4, D39-D41)
+#define COWPI_PH  7                 //!< Port number for PINH/DDRH/PORTH (pins D6-D9, D16-D17)
+#define COWPI_PJ  8                 //!< Port number for PINJ/DDRJ/PORTJ (pins D14-D15)
+#define COWPI_PK  9                 //!< Port number for PINK/DDRK/PORTK and PCMSK2 (pins D62-D69, aka A8-A15)
+#define A8_A15    9                 //!< Alias of COWPI_PK corresponding to pins D62-D69 (A8-A15) on the Arduino Mega 2560
+#define COWPI_PL  10                //!< Port number for PINL/DDRL/PORTL (pins D42-D49)
+#define COWPI_NUMBER_OF_PORTS 11    //!< Number of general-purpose I/O ports
+
+/**
+ * @brief Address of the I/O port structure for a port number (COWPI_PA, etc).
+ *
+ * Ports A-G are in the lower I/O space, and ports H-L are in the extended I/O
+ * space.
+ */
+#define COWPI_IOPORT(port) ((cowpi_ioport_t volatile *) ((port) < COWPI_PH ? COWPI_IO_BASE + 3 * (port) : COWPI_IO_BASE + 0xE0 + 3 * ((port) - COWPI_PH)))
+
+#define COWPI_PIN_PORT(pin) (                               \
+          (pin) <=  3 ? COWPI_PE                            \
+        : (pin) ==  4 ? COWPI_PG                            \
+        : (pin) ==  5 ? COWPI_PE                            \
+        : (pin) <=  9 ? COWPI_PH                            \
+        : (pin) <= 13 ? COWPI_PB                            \
+        : (pin) <= 15 ? COWPI_PJ                            \
+        : (pin) <= 17 ? COWPI_PH                            \
+        : (pin) <= 21 ? COWPI_PD                            \
+        : (pin) <= 29 ? COWPI_PA                            \
+        : (pin) <= 37 ? COWPI_PC                            \
+        : (pin) == 38 ? COWPI_PD                            \
+        : (pin) <= 41 ? COWPI_PG                            \
+        : (pin) <= 49 ? COWPI_PL                            \
+        : (pin) <= 53 ? COWPI_PB                            \
+        : (pin) <= 61 ? COWPI_PF                            \
+        :               COWPI_PK)                           //!< Port number (COWPI_PA, etc) of the I/O port for an Arduino pin number
+#define COWPI_PIN_BIT(pin) (                                \
+          (pin) <=  1 ? (pin)                               \
+        : (pin) <=  3 ? (pin) + 2                           \
+        : (pin) ==  4 ? 5                                   \
+        : (pin) ==  5 ? 3                                   \
+        : (pin) <=  9 ? (pin) - 3                           \
+        : (pin) <= 13 ? (pin) - 6                           \
+        : (pin) <= 15 ? 15 - (pin)                          \
+        : (pin) <= 17 ? 17 - (pin)                          \
+        : (pin) <= 21 ? 21 - (pin)                          \
+        : (pin) <= 29 ? (pin) - 22                          \
+        : (pin) <= 37 ? 37 - (pin)                          \
+        : (pin) == 38 ? 7                                   \
+        : (pin) <= 41 ? 41 - (pin)                          \
+        : (pin) <= 49 ? 49 - (pin)                          \
+        : (pin) <= 53 ? 53 - (pin)                          \
+        : (pin) <= 61 ? (pin) - 54                          \
+        :               (pin) - 62)                         //!< Position within its I/O port of an Arduino pin number
+#define COWPI_PIN_MASK(pin) (1 << COWPI_PIN_BIT(pin))       //!< Bitmask within its I/O port for an Arduino pin number
+
+
+/**
+ * @brief Structure for the general-purpose I/O pins.
+ *
+ * Use `COWPI_IOPORT()` to obtain the structure for a port.
+ */
+typedef struct {
+    uint8_t input;                      //!< Read inputs from this field (PINx)
+    uint8_t direction;                  //!< Set the pin's direction using this field (DDRx)
+    uint8_t output;                     //!< Write outputs to this field, and set/unset a pull-up resistor (PORTx)
+} cowpi_ioport_t;
+
+/**
+ * @brief Structure for the SPI hardware.
+ */
+typedef struct {
+    uint8_t control;                    //!< SPI control register (SPCR)
+    uint8_t status;                     //!< SPI status register (SPSR)
+    uint8_t data;                       //!< SPI data register (SPDR)
+} cowpi_spi_t;
+
+/**
+ * @brief Structure for the TWI (aka I2C, IIC) hardware.
+ */
+typedef struct {
+    uint8_t bit_rate;                   //!< TWI bit rate register, works in concert with status register (TWBR)
+    uint8_t status;                     //!< TWI status register (TWSR)
+    uint8_t address;                    //!< TWI peripheral address register (TWAR)
+    uint8_t data;                       //!< TWI data register (TWBB)
+    uint8_t control;                    //!< TWI control register(TWCR)
+    uint8_t peripheral_address_mask;    //!< TWI peripheral address mask register (TWAMR)
+} cowpi_i2c_t;
+
+/**
+ * @brief Structure for pin-based interrupts: pin change interrupts and external interrupts.
+ *
+ * PCMSK0 covers port B, PCMSK1 covers PE0 (pin D0) and PJ0-PJ6 (of which only
+ * D14 and D15 are connected), and PCMSK2 covers port K.
+ */
+typedef struct {
+    uint8_t pci_flags;                  //!< Pin change interrupt flag register (PCIFR)
+    uint8_t ei_flags;                   //!< External interrupt flag register (EIFR)
+    uint8_t ei_mask;                    //!< External interrupt mask register (EIMSK)
+    uint8_t DO_NOT_TOUCH[0x2A];         //!< padding
+    uint8_t pci_control;                //!< Pin change interrupt control register (PCICR)
+    uint8_t ei_control[2];              //!< External interrupt control registers A & B (EICRA, EICRB)
+    uint8_t pci_mask[3];                //!< Pin change mask registers (PCMSKx)
+} cowpi_pininterrupt_t;
+
+/**
+ * @brief Structure for 8-bit timer/counter (TIMER0 or TIMER2).
+ *
+ * The timer/counter interrupt mask register (TIMSKx) and the timer/counter
+ * interrupt flag register (TIFRx) are not part of this structure. Neither
+ * are the asynchronous status register (ASSR) nor the general timer/counter
+ * control register (GTCCR).
+ */
+typedef struct {
+    uint16_t control;                   //!< Timer/counter control registers A & B; register A is the low-order byte (TCCRxB TCCRxA)
+    uint8_t counter;                    //!< Timer/counter register (TCNTx)
+    uint8_t compareA;                   //!< Output compare register A (OCRxA)
+    uint8_t compareB;                   //!< Output compare register B (OCRxB)
+} cowpi_timer8bit_t;
+
+/**
+ * @brief Structure for 16-bit timer/counter (TIMER1, TIMER3, TIMER4, or
+ * TIMER5).
+ *
+ * The timer/counter interrupt mask register (TIMSKx) and the timer/counter
+ * interrupt flag register (TIFRx) are not part of this structure. Does not
+ * include the general timer/counter control register (GTCCR).
+ */
+typedef struct {
+    uint32_t control;                 //!< Timer/counter control registers A, B, & C; register A is the low-order byte (Reserved TCCRxC TCCRxB TCCRxA)
+    uint16_t counter;                 //!< Timer/counter register (TCNTxH TCNTxL, aka TCNTx)
+    uint16_t capture;                 //!< Input capture register (ICRxH ICRxL, aka ICRx)
+    uint16_t compareA;                //!< Output compare register A (OCRxAH OCRxAL, aka OCRxA)
+    uint16_t compareB;                //!< Output compare register B (OCRxBH OCRxBL, aka OCRxB)
+    uint16_t compareC;                //!< Output compare register C (OCRxCH OCRxCL, aka OCRxC)
+} cowpi_timer16bit_t;
+
+#endif //__AVR_ATmega2560__
+
+#endif //COWPI_ATMEGA2560_H
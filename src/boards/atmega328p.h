@@ -53,6 +53,9 @@
 #include "../setup/cowpi_setup.h"   //TODO: why is this include here?
 
 
+#define COWPI_IO_BASE ((uint8_t *) (0x20))  //!< Base address of the memory-mapped I/O registers
+
+
 #define COWPI_PB  0                 //!< Index for arrays to access PINB/DDRB/PORTB and PCMSK0
 #define D8_D13    0                 //!< Alias of COWPI_PB corresponding to pins D8-D13 on the Arduino Uno & Arduino Nano
 #define COWPI_PC  1                 //!< Index for arrays to access PINC/DDRC/PORTC / PCMSK1
@@ -63,6 +66,9 @@
 #define COWPI_PD  2                 //!< Index for arrays to access PIND/DDRD/PORTD and PCMSK2
 #define D0_D7     2                 //!< Alias of COWPI_PD for corresponding to pins D0-D7 on the Arduino Uno & Arduino Nano
 
+#define COWPI_PIN_PORT(pin) ((pin) < 8 ? COWPI_PD : (pin) < 14 ? COWPI_PB : COWPI_PC)                   //!< Index (COWPI_PB, etc) of the I/O port for an Arduino pin number
+#define COWPI_PIN_MASK(pin) (1 << ((pin) < 8 ? (pin) : (pin) < 14 ? (pin) - 8 : (pin) - 14))           //!< Bitmask within its I/O port for an Arduino pin number
+
 
 /**
  * @brief Structure for the general-purpose I/O pins.
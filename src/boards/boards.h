@@ -26,6 +26,7 @@
 #define COWPI_BOARDS_H
 
 #include "atmega328p.h"
+#include "atmega2560.h"
 #include "rp2040.h"
 
 #ifndef COWPI_USING_A_SUPPORTED_BOARD
@@ -42,9 +43,6 @@
 #elif defined (ARDUINO_NANO_RP2040_CONNECT)
 #warning CowPi has not yet been tested on Arduino Nano RP2040
 
-#elif defined (ARDUINO_AVR_MEGA2560)
-#warning CowPi does not yet have memory-mapped I/O data structures for Arduino Mega 2560
-
 // TODO: add the Uno R4 and Nano ESP32
 
 #else
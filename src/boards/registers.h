@@ -0,0 +1,401 @@
+/**************************************************************************//**
+ *
+ * @file registers.h
+ *
+ * @author Christopher A. Bohn
+ *
+ * @brief Typed C++ descriptors for the memory-mapped I/O registers.
+ *
+ * Each peripheral's structure (from atmega328p.h or rp2040.h) is paired with
+ * its base address at compile time, so there is no need to cast a raw address:
+ * @code
+ * cowpi::registers::spi::get()->data = byte;
+ * @endcode
+ *
+ * Individual registers have typed fields. Fields of the same register can be
+ * combined with `|`, and `modify()` applies all of them with a single load,
+ * a single bitwise AND/OR, and a single store:
+ * @code
+ * using cowpi::registers::spi_control;
+ * spi_control::modify(spi_control::enable::set()
+ *                     | spi_control::controller_mode::set()
+ *                     | spi_control::clock_rate::of(1));
+ * @endcode
+ * A field of one register cannot be applied to a different register; that is
+ * a compile-time error.
+ *
+ * Because the address, the masks, and (usually) the values are compile-time
+ * constants and every accessor is forced inline, an optimizing compiler can
+ * reduce `modify()` to the same instructions as hand-written register access,
+ * such as `SPCR = (SPCR & ~0x53) | 0x51`, and on the ATmega328P it may use an
+ * `sbi` or `cbi` instruction for a single bit of a register in the lower I/O
+ * space. This depends on the compiler and its optimization level; check the
+ * generated code where it matters.
+ *
+ * This was checked with GCC 12 at `-O2`, comparing the optimized intermediate
+ * code of descriptor-based and hand-written access for the ATmega328P (SPCR,
+ * SPSR, SPDR, TWCR, and PORTB) and for the RP2040 (SSPCR0, SSPCR1, SSPSR, and
+ * GPIO_OUT_SET). Each descriptor-based access had the same volatile loads and
+ * stores, in the same order, and the same number of bitwise operations, as
+ * its hand-written counterpart; only some AND masks differ, where the
+ * descriptor leaves a bit alone that the hand-written code clears and then
+ * sets. That intermediate code was then compiled with LLVM's back ends:
+ * - ATmega328P: setting or clearing a PORTB bit is a single `sbi` or `cbi`;
+ *   setting SPE in SPCR is `in`, `ori`, `out`; a multi-field `modify()` of SPCR
+ *   is `in`, `ori`, `andi`, `out`; and TWCR, outside of the I/O space, is
+ *   `lds`, `ori`, `andi`, `sts`
+ * - RP2040 (Cortex-M0+): setting SSE in SSPCR1 is `ldr`, `orrs`, `str`; a
+ *   multi-field `modify()` of SSPCR0 is `ldr`, `orrs`, `bics`, `str`; and a
+ *   store to the SIO's `atomic_set` is a single `str`
+ *
+ * The Arduino cores' own avr-gcc and arm-none-eabi-gcc were not available for
+ * this check.
+ *
+ * A flag that is cleared by writing 1 to it, such as TWINT in TWCR, is declared
+ * as part of its register's write-1-to-clear mask. `modify()` writes 0 to those
+ * bits unless they are among the fields being applied, so that changing another
+ * field does not clear a pending flag.
+ *
+ * These descriptors are available only in C++.
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COWPI_REGISTERS_H
+#define COWPI_REGISTERS_H
+
+#ifdef __cplusplus
+
+#include <stddef.h>
+#include <stdint.h>
+#include "boards.h"
+
+namespace cowpi {
+
+/**
+ * @brief The bits to be changed in a register, and their new values.
+ *
+ * Obtained from a field's `of()`, `set()`, or `clear()`; values for different
+ * fields of the same register are combined with `|`.
+ *
+ * @tparam REGISTER the register that the bits belong to
+ */
+template <typename REGISTER>
+struct FieldValue {
+    typedef typename REGISTER::value_type value_type;   //!< The register's width
+    value_type mask;                    //!< The bits to be changed
+    value_type value;                   //!< The new values of the bits to be changed
+    constexpr FieldValue(value_type mask, value_type value) : mask(mask), value(value) {}
+};
+
+/**
+ * @brief Combines the values of two sets of fields of the same register.
+ */
+template <typename REGISTER>
+constexpr FieldValue<REGISTER> operator|(FieldValue<REGISTER> a, FieldValue<REGISTER> b) {
+    return FieldValue<REGISTER>(static_cast<typename REGISTER::value_type>(a.mask | b.mask),
+                                static_cast<typename REGISTER::value_type>(a.value | b.value));
+}
+
+/**
+ * @brief A memory-mapped register whose address is known at compile time.
+ *
+ * Specific registers derive from this template, naming themselves as the first
+ * template argument, and declare their fields as member types.
+ *
+ * @tparam REGISTER the specific register
+ * @tparam T the register's width
+ * @tparam ADDRESS the register's address
+ * @tparam WRITE_1_TO_CLEAR the register's bits that are cleared by writing 1
+ *      to them
+ */
+template <typename REGISTER, typename T, uintptr_t ADDRESS, T WRITE_1_TO_CLEAR = 0>
+struct Register {
+    typedef T value_type;               //!< The register's width
+    static constexpr uintptr_t address = ADDRESS;   //!< The register's address
+    static constexpr T write_1_to_clear = WRITE_1_TO_CLEAR; //!< The bits that are cleared by writing 1 to them
+
+    /** @brief Provides direct access to the register. */
+    static inline __attribute__ ((always_inline)) T volatile &reference() {
+        return *reinterpret_cast<T volatile *>(ADDRESS);
+    }
+
+    /** @brief Reads the entire register. */
+    static inline __attribute__ ((always_inline)) T read() { return reference(); }
+
+    /** @brief Overwrites the entire register. */
+    static inline __attribute__ ((always_inline)) void write(T value) { reference() = value; }
+
+    /** @brief Overwrites the entire register; bits outside of `fields` become 0. */
+    static inline __attribute__ ((always_inline)) void write(FieldValue<REGISTER> fields) {
+        reference() = fields.value;
+    }
+
+    /**
+     * @brief Changes only the bits in `fields`, with a single load and a single store.
+     *
+     * Write-1-to-clear bits that are not in `fields` are written as 0, so they are not cleared.
+     */
+    static inline __attribute__ ((always_inline)) void modify(FieldValue<REGISTER> fields) {
+        T volatile &reg = reference();
+        T const bits_to_clear = static_cast<T>((fields.mask & ~fields.value) | WRITE_1_TO_CLEAR);
+        // when only setting bits, leave out the AND so that the compiler sees `reg |= value` (and can use `sbi`)
+        if (bits_to_clear) {
+            reg = static_cast<T>((reg & static_cast<T>(~bits_to_clear)) | fields.value);
+        } else {
+            reg = static_cast<T>(reg | fields.value);
+        }
+    }
+};
+
+/**
+ * @brief A field of one or more adjacent bits within a register.
+ *
+ * @tparam REGISTER the register that the field belongs to
+ * @tparam OFFSET the position of the field's least-significant bit
+ * @tparam WIDTH the number of bits in the field
+ */
+template <typename REGISTER, unsigned OFFSET, unsigned WIDTH = 1>
+struct Field {
+    typedef typename REGISTER::value_type value_type;   //!< The register's width
+    static_assert(OFFSET + WIDTH <= 8 * sizeof(value_type), "The field does not fit in its register");
+    static constexpr unsigned offset = OFFSET;          //!< The position of the field's least-significant bit
+    static constexpr value_type mask = static_cast<value_type>(((1uLL << WIDTH) - 1) << OFFSET);  //!< The field's bits
+
+    /** @brief The field's bits, set to `value`. */
+    static constexpr FieldValue<REGISTER> of(value_type value) {
+        return FieldValue<REGISTER>(mask, static_cast<value_type>((static_cast<unsigned long long>(value) << OFFSET) & mask));
+    }
+
+    /** @brief The field's bits, all set to 1. */
+    static constexpr FieldValue<REGISTER> set() { return FieldValue<REGISTER>(mask, mask); }
+
+    /** @brief The field's bits, all set to 0. */
+    static constexpr FieldValue<REGISTER> clear() { return FieldValue<REGISTER>(mask, 0); }
+
+    /** @brief Reads the field from the register. */
+    static inline __attribute__ ((always_inline)) value_type read() {
+        return static_cast<value_type>((REGISTER::read() & mask) >> OFFSET);
+    }
+
+    /** @brief Reports whether any of the field's bits are 1. */
+    static inline __attribute__ ((always_inline)) bool is_set() { return (REGISTER::read() & mask) != 0; }
+
+    /** @brief Changes only this field in the register. */
+    static inline __attribute__ ((always_inline)) void write(value_type value) { REGISTER::modify(of(value)); }
+};
+
+/**
+ * @brief A peripheral whose structure and base address are known at compile
+ * time.
+ *
+ * @tparam T the peripheral's structure, such as `cowpi_spi_t`
+ * @tparam ADDRESS the peripheral's base address
+ */
+template <typename T, uintptr_t ADDRESS>
+struct Peripheral {
+    typedef T structure_type;           //!< The peripheral's structure
+    static constexpr uintptr_t address = ADDRESS;   //!< The peripheral's base address
+
+    /** @brief Provides a pointer to the peripheral's structure. */
+    static inline __attribute__ ((always_inline)) T volatile *get() {
+        return reinterpret_cast<T volatile *>(ADDRESS);
+    }
+};
+
+
+namespace registers {
+
+#if defined (__AVR_ATmega328P__)
+
+/* *** PERIPHERALS *** (see ATmega328P datasheet) *** */
+
+typedef Peripheral<cowpi_ioport_t, 0x23> ioports;               //!< External pins; index with named constants (COWPI_PB, etc)
+typedef Peripheral<cowpi_pininterrupt_t, 0x3B> pin_interrupts;  //!< Pin-based interrupts
+typedef Peripheral<cowpi_spi_t, 0x4C> spi;                      //!< SPI protocol
+typedef Peripheral<cowpi_i2c_t, 0xB8> i2c;                      //!< I2C protocol
+typedef Peripheral<cowpi_timer8bit_t, 0x44> timer0;             //!< Timer0
+typedef Peripheral<cowpi_timer16bit_t, 0x80> timer1;            //!< Timer1
+typedef Peripheral<cowpi_timer8bit_t, 0xB0> timer2;             //!< Timer2
+
+static_assert(offsetof(cowpi_pininterrupt_t, pci_control) == 0x68 - 0x3B, "PCICR is misplaced in cowpi_pininterrupt_t");
+static_assert(offsetof(cowpi_pininterrupt_t, pci_mask) == 0x6B - 0x3B, "PCMSK0 is misplaced in cowpi_pininterrupt_t");
+static_assert(offsetof(cowpi_i2c_t, control) == 0xBC - 0xB8, "TWCR is misplaced in cowpi_i2c_t");
+static_assert(offsetof(cowpi_timer16bit_t, compareB) == 0x8A - 0x80, "OCR1B is misplaced in cowpi_timer16bit_t");
+
+
+/* *** REGISTERS *** */
+
+/** @brief SPI control register (SPCR) */
+struct spi_control : Register<spi_control, uint8_t, 0x4C> {
+    typedef Field<spi_control, 7> interrupt_enable;     //!< SPIE
+    typedef Field<spi_control, 6> enable;               //!< SPE
+    typedef Field<spi_control, 5> data_order;           //!< DORD (1 = LSB first)
+    typedef Field<spi_control, 4> controller_mode;      //!< MSTR
+    typedef Field<spi_control, 3> clock_polarity;       //!< CPOL
+    typedef Field<spi_control, 2> clock_phase;          //!< CPHA
+    typedef Field<spi_control, 0, 2> clock_rate;        //!< SPR1:0
+};
+
+/** @brief SPI status register (SPSR) */
+struct spi_status : Register<spi_status, uint8_t, 0x4D> {
+    typedef Field<spi_status, 7> interrupt_flag;        //!< SPIF
+    typedef Field<spi_status, 6> write_collision;       //!< WCOL
+    typedef Field<spi_status, 0> double_speed;          //!< SPI2X
+};
+
+/** @brief TWI status register (TWSR) */
+struct i2c_status : Register<i2c_status, uint8_t, 0xB9> {
+    typedef Field<i2c_status, 3, 5> status;             //!< TWS7:3
+    typedef Field<i2c_status, 0, 2> prescaler;          //!< TWPS1:0
+};
+
+/** @brief TWI control register (TWCR) */
+struct i2c_control : Register<i2c_control, uint8_t, 0xBC, 0x80> {
+    typedef Field<i2c_control, 7> interrupt_flag;       //!< TWINT (write 1 to clear; not written back by `modify()`)
+    typedef Field<i2c_control, 6> enable_acknowledge;   //!< TWEA
+    typedef Field<i2c_control, 5> start;                //!< TWSTA
+    typedef Field<i2c_control, 4> stop;                 //!< TWSTO
+    typedef Field<i2c_control, 3> write_collision;      //!< TWWC
+    typedef Field<i2c_control, 2> enable;               //!< TWEN
+    typedef Field<i2c_control, 0> interrupt_enable;     //!< TWIE
+};
+
+/** @brief External interrupt mask register (EIMSK) */
+struct external_interrupt_mask : Register<external_interrupt_mask, uint8_t, 0x3D> {
+    typedef Field<external_interrupt_mask, 0> int0_enable;      //!< INT0
+    typedef Field<external_interrupt_mask, 1> int1_enable;      //!< INT1
+};
+
+/** @brief Pin change interrupt control register (PCICR); bit positions match COWPI_PB, etc */
+struct pin_change_control : Register<pin_change_control, uint8_t, 0x68> {
+    typedef Field<pin_change_control, COWPI_PB> pb_enable;      //!< PCIE0
+    typedef Field<pin_change_control, COWPI_PC> pc_enable;      //!< PCIE1
+    typedef Field<pin_change_control, COWPI_PD> pd_enable;      //!< PCIE2
+};
+
+/** @brief External interrupt control register (EICRA) */
+struct external_interrupt_control : Register<external_interrupt_control, uint8_t, 0x69> {
+    typedef Field<external_interrupt_control, 0, 2> int0_sense; //!< ISC01:0 (0 = LOW, 1 = change, 2 = falling, 3 = rising)
+    typedef Field<external_interrupt_control, 2, 2> int1_sense; //!< ISC11:0 (0 = LOW, 1 = change, 2 = falling, 3 = rising)
+};
+
+/** @brief Timer/counter control register A (TCCRxA) for Timer0, Timer1, or Timer2 */
+template <unsigned TIMER>
+struct timer_control_a : Register<timer_control_a<TIMER>, uint8_t, TIMER == 0 ? 0x44 : TIMER == 1 ? 0x80 : 0xB0> {
+    static_assert(TIMER <= 2, "The ATmega328P has only Timer0, Timer1, and Timer2");
+    typedef Field<timer_control_a, 6, 2> compareA_mode;         //!< COMxA1:0
+    typedef Field<timer_control_a, 4, 2> compareB_mode;         //!< COMxB1:0
+    typedef Field<timer_control_a, 0, 2> waveform_low;          //!< WGMx1:0
+};
+
+/** @brief Timer/counter control register B (TCCRxB) for Timer0, Timer1, or Timer2 */
+template <unsigned TIMER>
+struct timer_control_b : Register<timer_control_b<TIMER>, uint8_t, TIMER == 0 ? 0x45 : TIMER == 1 ? 0x81 : 0xB1> {
+    static_assert(TIMER <= 2, "The ATmega328P has only Timer0, Timer1, and Timer2");
+    typedef Field<timer_control_b, 3, TIMER == 1 ? 2 : 1> waveform_high;    //!< WGM13:2 (Timer1) or WGMx2 (Timer0, Timer2)
+    typedef Field<timer_control_b, 0, 3> clock_select;          //!< CSx2:0
+};
+
+/** @brief Timer/counter interrupt mask register (TIMSKx) for Timer0, Timer1, or Timer2 */
+template <unsigned TIMER>
+struct timer_interrupt_mask : Register<timer_interrupt_mask<TIMER>, uint8_t, 0x6E + TIMER> {
+    static_assert(TIMER <= 2, "The ATmega328P has only Timer0, Timer1, and Timer2");
+    typedef Field<timer_interrupt_mask, 0> overflow_enable;     //!< TOIEx
+    typedef Field<timer_interrupt_mask, 1> compareA_enable;     //!< OCIExA
+    typedef Field<timer_interrupt_mask, 2> compareB_enable;     //!< OCIExB
+};
+
+#elif defined (ARDUINO_ARCH_RP2040)
+
+/* *** SINGLE-CYCLE I/O AND PERIPHERALS *** (see RP2040 datasheet) *** */
+
+typedef Peripheral<cowpi_ioport_t, 0xD0000000> ioport;              //!< External pins
+typedef Peripheral<cowpi_concurrency_t, 0xD0000050> concurrency;    //!< IPC FIFO pipes, and spinlocks
+typedef Peripheral<cowpi_timer_t, 0x40054000> timer;                //!< Timer
+typedef Peripheral<cowpi_spi_t, 0x4003C000> spi0;                   //!< SPI0
+typedef Peripheral<cowpi_spi_t, 0x40040000> spi1;                   //!< SPI1
+typedef Peripheral<cowpi_i2c_t, 0x40044000> i2c0;                   //!< I2C0
+typedef Peripheral<cowpi_i2c_t, 0x40048000> i2c1;                   //!< I2C1
+typedef Peripheral<cowpi_iobank_t, 0x40014000> iobank;             //!< Pin function selection; index with pin number
+typedef Peripheral<cowpi_pads_t, 0x4001C000> pads;                  //!< Pin pads
+
+static_assert(offsetof(cowpi_ioport_t, atomic_toggle_enable) == 0x2C, "GPIO_OE_XOR is misplaced in cowpi_ioport_t");
+static_assert(offsetof(cowpi_concurrency_t, spinlocks) == 0x100 - 0x50, "SPINLOCK0 is misplaced in cowpi_concurrency_t");
+static_assert(offsetof(cowpi_timer_t, pause) == 0x30, "PAUSE is misplaced in cowpi_timer_t");
+static_assert(offsetof(cowpi_spi_t, status) == 0xC, "SSPSR is misplaced in cowpi_spi_t");
+static_assert(offsetof(cowpi_i2c_t, enable) == 0x6C, "IC_ENABLE is misplaced in cowpi_i2c_t");
+static_assert(sizeof(cowpi_iobank_t) == 0x8, "GPIO1_STATUS is misplaced in cowpi_iobank_t[]");
+static_assert(offsetof(cowpi_pads_t, swd) == 0x80, "SWD is misplaced in cowpi_pads_t");
+
+
+/* *** REGISTERS *** */
+
+/** @brief SSP control register 0 (SSPCR0) of SPI0 (`0x4003C000`) or SPI1 (`0x40040000`) */
+template <uintptr_t BASE>
+struct spi_control0 : Register<spi_control0<BASE>, uint32_t, BASE + 0x0> {
+    typedef Field<spi_control0, 8, 8> serial_clock_rate;        //!< SCR
+    typedef Field<spi_control0, 7> clock_phase;                 //!< SPH
+    typedef Field<spi_control0, 6> clock_polarity;              //!< SPO
+    typedef Field<spi_control0, 4, 2> frame_format;             //!< FRF (0 = Motorola SPI)
+    typedef Field<spi_control0, 0, 4> data_size;                //!< DSS (bits per frame, minus 1)
+};
+
+/** @brief SSP control register 1 (SSPCR1) of SPI0 (`0x4003C000`) or SPI1 (`0x40040000`) */
+template <uintptr_t BASE>
+struct spi_control1 : Register<spi_control1<BASE>, uint32_t, BASE + 0x4> {
+    typedef Field<spi_control1, 3> output_disable;              //!< SOD
+    typedef Field<spi_control1, 2> peripheral_mode;             //!< MS
+    typedef Field<spi_control1, 1> enable;                      //!< SSE
+    typedef Field<spi_control1, 0> loopback;                    //!< LBM
+};
+
+/** @brief SSP status register (SSPSR) of SPI0 (`0x4003C000`) or SPI1 (`0x40040000`) */
+template <uintptr_t BASE>
+struct spi_status : Register<spi_status<BASE>, uint32_t, BASE + 0xC> {
+    typedef Field<spi_status, 4> busy;                          //!< BSY
+    typedef Field<spi_status, 3> rx_fifo_full;                  //!< RFF
+    typedef Field<spi_status, 2> rx_fifo_not_empty;             //!< RNE
+    typedef Field<spi_status, 1> tx_fifo_not_full;              //!< TNF
+    typedef Field<spi_status, 0> tx_fifo_empty;                 //!< TFE
+};
+
+/** @brief I2C control register (IC_CON) of I2C0 (`0x40044000`) or I2C1 (`0x40048000`) */
+template <uintptr_t BASE>
+struct i2c_control : Register<i2c_control<BASE>, uint32_t, BASE + 0x0> {
+    typedef Field<i2c_control, 6> peripheral_disable;           //!< IC_SLAVE_DISABLE
+    typedef Field<i2c_control, 5> restart_enable;               //!< IC_RESTART_EN
+    typedef Field<i2c_control, 4> controller_10bit_address;     //!< IC_10BITADDR_MASTER
+    typedef Field<i2c_control, 3> peripheral_10bit_address;     //!< IC_10BITADDR_SLAVE
+    typedef Field<i2c_control, 1, 2> speed;                     //!< SPEED (1 = standard, 2 = fast)
+    typedef Field<i2c_control, 0> controller_mode;              //!< MASTER_MODE
+};
+
+/** @brief I2C enable register (IC_ENABLE) of I2C0 (`0x40044000`) or I2C1 (`0x40048000`) */
+template <uintptr_t BASE>
+struct i2c_enable : Register<i2c_enable<BASE>, uint32_t, BASE + 0x6C> {
+    typedef Field<i2c_enable, 1> abort;                         //!< ABORT
+    typedef Field<i2c_enable, 0> enable;                        //!< ENABLE
+};
+
+#endif //MICROCONTROLLER
+
+} // namespace registers
+
+} // namespace cowpi
+
+#endif //__cplusplus
+
+#endif //COWPI_REGISTERS_H
@@ -20,6 +20,13 @@
  * |                                                |                       | 0x4004'8000 (I2C1) |
  * | Timer                                          | cowpi_timer_t         | 0x4005'4000        |
  * | IPC FIFO pipes, and spinlocks                  | cowpi_concurrency_t   | 0xD000'0050        |
+ * | Pin function selection                         | cowpi_iobank_t[30]    | 0x4001'4000        |
+ * | Pin pads (pullups, pulldowns, input enable)    | cowpi_pads_t          | 0x4001'C000        |
+ *
+ * Every peripheral register (but not the single-cycle I/O registers) can also
+ * be accessed through aliases that atomically set or clear bits: add
+ * `COWPI_ATOMIC_SET_OFFSET` or `COWPI_ATOMIC_CLEAR_OFFSET` to the register's
+ * address.
  *
  ******************************************************************************/
 
@@ -44,6 +51,11 @@
 
 #include <stdint.h>
 
+
+#define COWPI_IO_BASE ((uint8_t *) (0xD0000000))    //!< Base address of the single-cycle I/O registers
+#define COWPI_ATOMIC_SET_OFFSET     (0x2000)        //!< Offset from a peripheral register to its atomic bit-set alias
+#define COWPI_ATOMIC_CLEAR_OFFSET   (0x3000)        //!< Offset from a peripheral register to its atomic bit-clear alias
+
 /* *** SINGLE-CYCLE I/O *** (see RP2040 datasheet, section 2.3.1) *** */
 
 /**
@@ -80,8 +92,8 @@ typedef struct {
     uint32_t pipe_write;                //!< Write word in this field to send message to other core
     uint32_t pipe_read;                 //!< Read word from this field to obtain message from other core
     uint32_t spinlock_status;           //!< Status of each of the 32 mutex tokens (1=locked, 0=unlocked)
-    uint32_t DO_NOT_TOUCH_1[0x20];      //!< padding (divider)
-    uint32_t DO_NOT_TOUCH_2[0x80];      //!< padding (interpolators)
+    uint32_t DO_NOT_TOUCH_1[0x08];      //!< padding (divider)
+    uint32_t DO_NOT_TOUCH_2[0x20];      //!< padding (interpolators)
     uint32_t spinlocks[32];             //!< Busy-wait until reading produces non-zero value; write to release (see datasheet)
 } cowpi_concurrency_t;
 
@@ -115,6 +127,41 @@ typedef struct {
     // skip over the interrupt-related registers (for now?)
 } cowpi_timer_t;
 
+/**
+ * @brief Structure for a pin's status and function selection.
+ *
+ * An array of these structures, indexed by the pin number, starts at the
+ * IO_BANK0 base address. The lowest 5 bits of `control` select the pin's
+ * function; function 5 connects the pin to the single-cycle I/O registers
+ * (`cowpi_ioport_t`).
+ */
+typedef struct {
+    uint32_t status;                    //!< GPIO status register (GPIOx_STATUS)
+    uint32_t control;                   //!< GPIO control register, including function select and overrides (GPIOx_CTRL)
+} cowpi_iobank_t;
+
+/**
+ * @brief Structure for the pins' pad controls.
+ *
+ * Each pin's pad control register enables the pin's input and output buffers
+ * and its pullup and pulldown resistors:
+ * | Bit | Meaning                       |
+ * |:---:|:------------------------------|
+ * | 7   | Output disable (OD)           |
+ * | 6   | Input enable (IE)             |
+ * | 5-4 | Drive strength (DRIVE)        |
+ * | 3   | Pullup enable (PUE)           |
+ * | 2   | Pulldown enable (PDE)         |
+ * | 1   | Schmitt trigger (SCHMITT)     |
+ * | 0   | Fast slew rate (SLEWFAST)     |
+ */
+typedef struct {
+    uint32_t voltage_select;            //!< Pad voltage select register (VOLTAGE_SELECT)
+    uint32_t gpio[30];                  //!< Pad control registers, indexed by pin number (GPIOx)
+    uint32_t swclk;                     //!< Pad control register for the SWCLK pin (SWCLK)
+    uint32_t swd;                       //!< Pad control register for the SWD pin (SWD)
+} cowpi_pads_t;
+
 /**
  * @brief Structure for the SSP hardware (which we will use for SPI).
  * 
@@ -147,7 +194,7 @@ typedef struct {
     uint32_t standard_clock_low_count;  //!< I2C standard speed SCL low Count register (IC_SS_SCL_LCNT)
     uint32_t fast_clock_high_count;     //!< I2C fast speed SCL high Count register (IC_FS_SCL_HCNT)
     uint32_t fast_clock_low_count;      //!< I2C fast speed SCL low Count register (IC_FS_SCL_LCNT)
-    uint32_t DO_NOT_TOUCH[0x50];        //!< padding (interrupt-related registers)
+    uint32_t DO_NOT_TOUCH[0x12];        //!< padding (interrupt-related registers)
     uint32_t enable;                    //!< I2C enable register (IC_ENABLE)
     uint32_t status;                    //!< I2C status register (IC_STATUS)
     uint32_t tx_fifo_level;             //!< I2C transmit FIFO level register (IC_TXFLR)
@@ -68,14 +68,12 @@ static const uint8_t RIGHT_SWITCH_SPI       = 19;   // aka A5
 static const uint8_t LEFT_SWITCH_I2C        = 11;
 static const uint8_t RIGHT_SWITCH_I2C       = 10;
     // keypad
-static const uint8_t KEYPAD_ROW_1           = 4;
-static const uint8_t KEYPAD_ROW_4           = 5;
-static const uint8_t KEYPAD_ROW_7           = 6;
-static const uint8_t KEYPAD_ROW_STAR        = 7;
-static const uint8_t KEYPAD_COLUMN_1        = 14;   // aka A0
-static const uint8_t KEYPAD_COLUMN_2        = 15;   // aka A1
-static const uint8_t KEYPAD_COLUMN_3        = 16;   // aka A2
-static const uint8_t KEYPAD_COLUMN_A        = 17;   // aka A3
+#ifndef COWPI_KEYPAD_ROW_PINS
+#define COWPI_KEYPAD_ROW_PINS(ROW)          ROW(4) ROW(5) ROW(6) ROW(7)
+#endif //COWPI_KEYPAD_ROW_PINS
+#ifndef COWPI_KEYPAD_COLUMN_PINS
+#define COWPI_KEYPAD_COLUMN_PINS(COLUMN)    COLUMN(14) COLUMN(15) COLUMN(16) COLUMN(17)   // aka A0-A3
+#endif //COWPI_KEYPAD_COLUMN_PINS
     // display
 static const uint8_t CHIP_SELECT_SPI        = 10;
 static const uint8_t DATA_SPI               = 11;
@@ -98,14 +96,12 @@ static const uint8_t RIGHT_SWITCH_SPI       = 59;   // aka A5
 static const uint8_t LEFT_SWITCH_I2C        = 11;
 static const uint8_t RIGHT_SWITCH_I2C       = 10;
     // keypad
-static const uint8_t KEYPAD_ROW_1           = 4;
-static const uint8_t KEYPAD_ROW_4           = 5;
-static const uint8_t KEYPAD_ROW_7           = 6;
-static const uint8_t KEYPAD_ROW_STAR        = 7;
-static const uint8_t KEYPAD_COLUMN_1        = 54;   // aka A0
-static const uint8_t KEYPAD_COLUMN_2        = 55;   // aka A1
-static const uint8_t KEYPAD_COLUMN_3        = 56;   // aka A2
-static const uint8_t KEYPAD_COLUMN_A        = 57;   // aka A3
+#ifndef COWPI_KEYPAD_ROW_PINS
+#define COWPI_KEYPAD_ROW_PINS(ROW)          ROW(4) ROW(5) ROW(6) ROW(7)
+#endif //COWPI_KEYPAD_ROW_PINS
+#ifndef COWPI_KEYPAD_COLUMN_PINS
+#define COWPI_KEYPAD_COLUMN_PINS(COLUMN)    COLUMN(54) COLUMN(55) COLUMN(56) COLUMN(57)   // aka A0-A3
+#endif //COWPI_KEYPAD_COLUMN_PINS
     // display
 static const uint8_t CHIP_SELECT_SPI        = 10;   // TODO ????--not 53--need to fix the CowPi_stdio default
 static const uint8_t DATA_SPI               = 51;
@@ -129,14 +125,12 @@ static const uint8_t RIGHT_SWITCH_SPI       = 15;
 static const uint8_t LEFT_SWITCH_I2C        = 14;
 static const uint8_t RIGHT_SWITCH_I2C       = 15;
     // keypad
-static const uint8_t KEYPAD_ROW_1           = 6;
-static const uint8_t KEYPAD_ROW_4           = 7;
-static const uint8_t KEYPAD_ROW_7           = 8;
-static const uint8_t KEYPAD_ROW_STAR        = 9;
-static const uint8_t KEYPAD_COLUMN_1        = 10;
-static const uint8_t KEYPAD_COLUMN_2        = 11;
-static const uint8_t KEYPAD_COLUMN_3        = 12;
-static const uint8_t KEYPAD_COLUMN_A        = 13;
+#ifndef COWPI_KEYPAD_ROW_PINS
+#define COWPI_KEYPAD_ROW_PINS(ROW)          ROW(6) ROW(7) ROW(8) ROW(9)
+#endif //COWPI_KEYPAD_ROW_PINS
+#ifndef COWPI_KEYPAD_COLUMN_PINS
+#define COWPI_KEYPAD_COLUMN_PINS(COLUMN)    COLUMN(10) COLUMN(11) COLUMN(12) COLUMN(13)
+#endif //COWPI_KEYPAD_COLUMN_PINS
     // display
 static const uint8_t CHIP_SELECT_SPI        = 17;
 static const uint8_t DATA_SPI               = 19;
@@ -148,6 +142,10 @@ static const uint8_t CLOCK_I2C              = 5;
 #error CowPi does not yet support your microcontroller board
 #endif //FORMFACTOR
 
+#ifndef COWPI_KEYPAD_LEGEND
+#define COWPI_KEYPAD_LEGEND                 "123A456B789C*0#D"
+#endif //COWPI_KEYPAD_LEGEND
+
 
 /* Global variable declarations */
 
@@ -190,6 +188,32 @@ extern "C" {
  */
 void cowpi_pin_mode(pin_number_t pin, pin_mode_t mode);
 
+/**
+ * @brief Has the input-sampling interrupt scan the keypad whenever it is
+ * neither scanned in the background nor interrupt-driven.
+ *
+ * While the keypad is sampled, `cowpi_get_keypress()` and its siblings examine
+ * the most recent sample instead of scanning the keypad.
+ */
+void cowpi_enable_keypad_sampling(void);
+
+/**
+ * @brief Stops the input-sampling interrupt from scanning the keypad.
+ */
+void cowpi_disable_keypad_sampling(void);
+
+/**
+ * @brief Reports the keys that are pressed, for the input-sampling interrupt.
+ *
+ * If the keypad is sampled, then it is scanned; otherwise, the keypad's
+ * background or interrupt-driven scanning is reported. Must be called from the
+ * input-sampling ISR or while that ISR cannot run.
+ *
+ * @return the keys in the same bit positions as `cowpi_get_keypresses()`, or 0
+ *      if the keypad is only polled
+ */
+uint16_t cowpi_sample_keypresses(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -197,7 +221,7 @@ void cowpi_pin_mode(pin_number_t pin, pin_mode_t mode);
 
 /* Macros for internal use only */
 
-// none
+#define UNASSIGNED_PIN (255)                // the value of a pin variable whose pin has not been determined
 
 /** @endcond */
 
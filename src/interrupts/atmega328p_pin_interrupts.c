@@ -8,9 +8,17 @@
  *
  * Provides functions to register and deregister functions to handle to
  * pin change interrupts. The functions allow for a function specific to each
- * pin (or combination of pins), similar to external interrupts. Unlike external
- * interrupts, there is no option for only-rising or only-falling interrupt
- * handlers.
+ * pin (or combination of pins), similar to external interrupts. Like external
+ * interrupts, a function can be registered for only rising edges, only falling
+ * edges, or both; the pin change interrupts fire on both edges, and the
+ * dispatcher discards the edges that the pin's function is not registered for.
+ *
+ * Pins D2 and D3 use the external interrupts INT0 and INT1 instead of pin
+ * change interrupts; their edges are selected in hardware, and their functions
+ * are invoked with the lowest possible latency.
+ *
+ * Quadrature encoders are decoded directly in the vectors, without invoking a
+ * registered function.
  *
  ******************************************************************************/
 
@@ -29,141 +37,861 @@
 
 #if defined ARDUINO_AVR_UNO || defined ARDUINO_AVR_NANO
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
 #include "pin_interrupts.h"
+#include "../internal/cowpi_internal.h"
+#include "../boards/boards.h"
 
 static void do_nothing(void) {}
 
-static void (*interrupt_service_routines[])(void) = {
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing,
-        do_nothing
+struct pin_isr {
+    union {
+        void (*without_context)(void);
+        void (*with_context)(uint8_t pin, cowpi_pin_edge_t edge, void *context);
+    };
+    void *context;
 };
 
+static struct pin_isr interrupt_service_routines[20] = {
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing},
+        {.without_context = do_nothing}
+};
+
+// indexed by the I/O bank (COWPI_PB, etc), the most recent values of the pins whose PCMSKx bits are set...
 static volatile uint8_t inputs[3];
+// ...and the pins whose ISRs are run on each edge
+static volatile uint8_t rising_edge_pins[3];
+static volatile uint8_t falling_edge_pins[3];
+// ...and the pins whose ISRs take a context
+static volatile uint8_t context_pins[3];
+// ...and the pins that are locked out after their ISRs run, and the pins that are currently locked out
+static volatile uint8_t lockout_pins[3];
+static volatile uint8_t locked_pins[3];
+// ...and the values of the locked-out pins when they were last sampled
+static volatile uint8_t sampled_inputs[3];
+
+// the first pin in each I/O bank, indexed by the I/O bank
+static uint8_t const first_pins[3] = {8, 14, 0};
+
+// indexed by the pin, the length of its lockout in TIMER0 periods, the periods remaining in its current lockout, and
+// the number of changes during its lockouts that its ISR would otherwise have been invoked for
+static uint8_t lockout_periods[20];
+static volatile uint8_t remaining_lockout_periods[20];
+static volatile uint16_t dropped_events[20];
+
+// indexed by the I/O bank, the pins whose edges are coalesced, and the coalesced pins that had edges in this window
+static volatile uint8_t coalesced_pins[3];
+static volatile uint8_t coalesced_changes[3];
+// indexed by the pin, the number of edges in this window on a coalesced pin
+static volatile uint16_t edge_counts[20];
+
+#define COALESCED_ISRS 4
+
+struct coalesced_pin_isr {
+    void (*isr)(cowpi_coalesced_pin_events_t const *events, void *context);
+    void *context;
+    cowpi_pin_set_t pins;               // no pins indicates that the entry is available
+    uint16_t window_periods;            // 0 indicates that the ISR is invoked from loop()
+    uint16_t remaining_window_periods;
+};
+
+static struct coalesced_pin_isr coalesced_isrs[COALESCED_ISRS];
+
+struct encoder {
+    int32_t volatile position;
+    uint16_t volatile illegal_transitions;
+    uint8_t state;                      // A:B when the encoder was last decoded
+    uint8_t a_pin;
+    uint8_t b_pin;
+    uint8_t a_bank;
+    uint8_t b_bank;
+    uint8_t a_mask;
+    uint8_t b_mask;
+};
+
+static struct encoder encoders[COWPI_MAX_ENCODERS];
+// the registered encoders (bit i for encoder i)
+static uint8_t encoders_in_use;
+// indexed by the I/O bank, the pins that are encoder outputs, and the encoders with an output in the bank
+static volatile uint8_t encoder_pins[3];
+static volatile uint8_t encoders_in_bank[3];
+
+// the position of the lowest 1 bit in each byte (8 for 0x00)
+static uint8_t const lowest_set_bit[256] PROGMEM = {
+        8, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+        4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,
+};
+
+static void set_edges(uint8_t io_bank, uint8_t pins, cowpi_pin_edge_t edges) {
+    if (edges & COWPI_RISING_EDGE) {
+        rising_edge_pins[io_bank] |= pins;
+    } else {
+        rising_edge_pins[io_bank] &= ~pins;
+    }
+    if (edges & COWPI_FALLING_EDGE) {
+        falling_edge_pins[io_bank] |= pins;
+    } else {
+        falling_edge_pins[io_bank] &= ~pins;
+    }
+}
+
+#define PINS_IN_PD(pins) ((uint8_t) ((pins) & 0xFF))             // D0 -- D7,   PCINT2
+#define PINS_IN_PB(pins) ((uint8_t) (((pins) >> 8) & 0x3F))      // D8 -- D13,  PCINT0
+#define PINS_IN_PC(pins) ((uint8_t) (((pins) >> 14) & 0x3F))     // D14 -- D19, PCINT1
+
+// must be called with interrupts disabled
+static void remove_encoders(cowpi_pin_set_t pins) {
+    uint8_t in_use = encoders_in_use;
+    while (in_use) {
+        uint8_t i = pgm_read_byte(lowest_set_bit + in_use);
+        struct encoder const *encoder = encoders + i;
+        if (pins & (COWPI_PIN_SET(encoder->a_pin) | COWPI_PIN_SET(encoder->b_pin))) {
+            encoders_in_use &= ~(1 << i);
+            encoder_pins[encoder->a_bank] &= ~encoder->a_mask;
+            encoder_pins[encoder->b_bank] &= ~encoder->b_mask;
+            encoders_in_bank[encoder->a_bank] &= ~(1 << i);
+            encoders_in_bank[encoder->b_bank] &= ~(1 << i);
+        }
+        in_use &= in_use - 1;           // clear the lowest 1 bit
+    }
+}
 
-void cowpi_register_pin_ISR(uint32_t interrupt_mask, void (*isr)(void)) {
-    PCICR = 0x0;    // disable pin change interrupts while we're making changes
-    int8_t i = 0;
-    do {
-        if (interrupt_mask & (1L << i)) {
-            interrupt_service_routines[i] = isr;
-            if (i < 8) {            // D0 -- D7,   PCINT2
-                PCMSK2 |= (1 << (i - 0));
-                inputs[2] = PIND & PCMSK2;
-                PCIFR = 0x4;  // write a 1 to *only* the relevant PCIFR bit
-            } else if (i < 14) {    // D8 -- D13,  PCINT0
-                PCMSK0 |= (1 << (i - 8));
-                inputs[0] = PINB & PCMSK0;
-                PCIFR = 0x2;
-            } else {                // D14 -- D19, PCINT1
-                PCMSK1 |= (1 << (i - 14));
-                inputs[1] = PINC & PCMSK1;
-                PCIFR = 0x1;
+static void set_isrs(cowpi_pin_set_t pins, struct pin_isr isr, bool has_context) {
+    pins &= 0xFFFFF;                    // D0 -- D19
+    // the pins are no longer coalesced, unless they are being registered for coalescing again
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        for (uint8_t i = 0; i < COALESCED_ISRS; i++) {
+            coalesced_isrs[i].pins &= ~pins;
+        }
+        coalesced_pins[COWPI_PD] &= ~PINS_IN_PD(pins);
+        coalesced_pins[COWPI_PB] &= ~PINS_IN_PB(pins);
+        coalesced_pins[COWPI_PC] &= ~PINS_IN_PC(pins);
+        remove_encoders(pins);
+    }
+    while (pins) {
+        uint8_t pin = __builtin_ctzl(pins);
+        uint8_t io_bank = COWPI_PIN_PORT(pin);
+        // the ISR might be running for this pin, so don't let it see a half-written ISR
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            interrupt_service_routines[pin] = isr;
+            if (has_context) {
+                context_pins[io_bank] |= COWPI_PIN_MASK(pin);
+            } else {
+                context_pins[io_bank] &= ~COWPI_PIN_MASK(pin);
             }
         }
-    } while (++i < 32);
-    PCICR = 0x7;    // re-enable pin change interrupts
-}
-
-void cowpi_deregister_pin_ISR(uint32_t interrupt_mask) {
-    PCICR = 0x0;    // disable pin change interrupts while we're making changes
-    int8_t i = 0;
-    do {
-        if (interrupt_mask & (1 << i)) {
-            interrupt_service_routines[i] = do_nothing;
-            if (i < 8) {            // D0 -- D7,   PCINT2
-                PCMSK2 &= ~(1 << (i - 0));
-            } else if (i < 14) {    // D8 -- D13,  PCINT0
-                PCMSK0 &= ~(1 << (i - 8));
-            } else {                // D14 -- D19, PCINT1
-                PCMSK1 &= ~(1 << (i - 14));
+        pins &= pins - 1;               // clear the lowest 1 bit
+    }
+}
+
+/*
+ * Only the affected I/O bank is changed, and only within a critical section of approximately 30 cycles on a 16MHz
+ * ATmega328P (estimated from the instruction sequence). The other banks' pin change interrupts remain enabled, and a
+ * change that occurs during the critical section is serviced as soon as it ends. The pins whose interrupts are already
+ * enabled keep their previous values in inputs[], so that a change that hasn't yet been serviced won't be lost; only
+ * the newly-enabled pins take their current values.
+ */
+static void enable_pins(uint8_t io_bank, uint8_t pins, cowpi_pin_edge_t edges) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    if (!pins) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        set_edges(io_bank, pins, edges);
+        // a locked-out pin's PCMSKx bit is clear, so it is newly-enabled, and its lockout ends
+        uint8_t newly_enabled_pins = pins & ~pin_interrupts->pci_mask[io_bank];
+        locked_pins[io_bank] &= ~pins;
+        pin_interrupts->pci_mask[io_bank] |= pins;
+        inputs[io_bank] = (inputs[io_bank] & ~newly_enabled_pins) | (ioports[io_bank].input & newly_enabled_pins);
+        pin_interrupts->pci_control |= 1 << io_bank;    // PCIEx bit positions match the I/O bank indices
+    }
+}
+
+static void disable_pins(uint8_t io_bank, uint8_t pins) {
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    if (!pins) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pin_interrupts->pci_mask[io_bank] &= ~pins;
+        rising_edge_pins[io_bank] &= ~pins;
+        falling_edge_pins[io_bank] &= ~pins;
+        locked_pins[io_bank] &= ~pins;
+        inputs[io_bank] &= ~pins;
+        if (!pin_interrupts->pci_mask[io_bank]) {
+            pin_interrupts->pci_control &= ~(1 << io_bank);
+        }
+    }
+}
+
+/*
+ * D2 and D3 have their own external interrupts (INT0 and INT1), which select the edges in hardware and need no
+ * software comparison to find the pin that changed, so they are used instead of PCINT2 for those pins. Their bits in
+ * rising_edge_pins[COWPI_PD] and falling_edge_pins[COWPI_PD] are used only for lockouts, and their bits in
+ * inputs[COWPI_PD] are 0 except during a lockout; because their PCMSK2 bits are never set, the pin change dispatcher
+ * never sees them change.
+ */
+#define EXTERNAL_INTERRUPT_PINS (COWPI_PIN_SET(2) | COWPI_PIN_SET(3))
+
+static void enable_external_interrupt(uint8_t pin, cowpi_pin_edge_t edges) {
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    uint8_t interrupt_bit = 1 << (pin - 2);         // INTx bit in EIMSK and EIFR
+    uint8_t sense_shift = 2 * (pin - 2);            // position of ISCx1:ISCx0 in EICRA
+    // ISCx1:ISCx0 -- 01 = any change, 10 = falling edge, 11 = rising edge
+    uint8_t sense = (edges == COWPI_BOTH_EDGES) ? 0x1 : (edges == COWPI_FALLING_EDGE) ? 0x2 : 0x3;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        set_edges(COWPI_PD, COWPI_PIN_MASK(pin), edges);
+        locked_pins[COWPI_PD] &= ~COWPI_PIN_MASK(pin);
+        inputs[COWPI_PD] &= ~COWPI_PIN_MASK(pin);
+        // changing the sense can set the interrupt flag, so the datasheet's order must be followed
+        pin_interrupts->ei_mask &= ~interrupt_bit;
+        pin_interrupts->ei_control = (pin_interrupts->ei_control & ~(0x3 << sense_shift)) | (sense << sense_shift);
+        pin_interrupts->ei_flags = interrupt_bit;   // write a 1 to *only* the relevant EIFR bit
+        pin_interrupts->ei_mask |= interrupt_bit;
+    }
+}
+
+static void disable_external_interrupt(uint8_t pin) {
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pin_interrupts->ei_mask &= ~(1 << (pin - 2));
+        set_edges(COWPI_PD, COWPI_PIN_MASK(pin), 0);
+        locked_pins[COWPI_PD] &= ~COWPI_PIN_MASK(pin);
+        inputs[COWPI_PD] &= ~COWPI_PIN_MASK(pin);
+    }
+}
+
+void cowpi_register_pin_ISR(cowpi_pin_set_t interrupt_mask, void (*isr)(void)) {
+    cowpi_register_pin_edge_ISR(interrupt_mask, COWPI_BOTH_EDGES, isr);
+}
+
+static void enable_interrupts(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges) {
+    if (interrupt_mask & COWPI_PIN_SET(2)) {
+        enable_external_interrupt(2, edges);
+    }
+    if (interrupt_mask & COWPI_PIN_SET(3)) {
+        enable_external_interrupt(3, edges);
+    }
+    enable_pins(COWPI_PD, PINS_IN_PD(interrupt_mask & ~EXTERNAL_INTERRUPT_PINS), edges);
+    enable_pins(COWPI_PB, PINS_IN_PB(interrupt_mask), edges);
+    enable_pins(COWPI_PC, PINS_IN_PC(interrupt_mask), edges);
+}
+
+static void register_isrs(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges, struct pin_isr isr,
+                          bool has_context) {
+    // the ISRs must be in place before their pins' interrupts are enabled
+    set_isrs(interrupt_mask, isr, has_context);
+    enable_interrupts(interrupt_mask, edges);
+}
+
+void cowpi_register_pin_edge_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges, void (*isr)(void)) {
+    register_isrs(interrupt_mask, edges, (struct pin_isr) {.without_context = isr}, false);
+}
+
+void cowpi_register_pin_context_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges,
+                                    void (*isr)(uint8_t pin, cowpi_pin_edge_t edge, void *context), void *context) {
+    register_isrs(interrupt_mask, edges, (struct pin_isr) {.with_context = isr, .context = context}, true);
+}
+
+void cowpi_deregister_pin_ISR(cowpi_pin_set_t interrupt_mask) {
+    // the pins' interrupts must be disabled before their ISRs are removed
+    if (interrupt_mask & COWPI_PIN_SET(2)) {
+        disable_external_interrupt(2);
+    }
+    if (interrupt_mask & COWPI_PIN_SET(3)) {
+        disable_external_interrupt(3);
+    }
+    disable_pins(COWPI_PD, PINS_IN_PD(interrupt_mask & ~EXTERNAL_INTERRUPT_PINS));
+    disable_pins(COWPI_PB, PINS_IN_PB(interrupt_mask));
+    disable_pins(COWPI_PC, PINS_IN_PC(interrupt_mask));
+    set_isrs(interrupt_mask, (struct pin_isr) {.without_context = do_nothing}, false);
+}
+
+/* Lockouts */
+
+/*
+ * A locked-out pin's PCMSKx bit (or, for D2 and D3, its EIMSK bit) is cleared so that a bouncing contact or a floating
+ * input cannot fire its interrupt, and inputs[] keeps the pin's value from when its ISR was invoked. TIMER0's
+ * comparison B interrupt, which the Arduino core doesn't use, fires once per TIMER0 period (1.024ms) while any pin is
+ * locked out (or while a coalescing window is timed): it samples the locked-out pins to count the changes that were
+ * dropped, and it ends each lockout when the pin's periods have elapsed.
+ */
+
+static void service_lockouts_and_windows(void);
+
+// TIMER0's comparison B interrupt services the lockouts and windows only after they have been used
+static void (* volatile timer0_compb_handler)(void) = NULL;
+
+static void use_timer0_compb(void) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        timer0_compb_handler = service_lockouts_and_windows;
+    }
+}
+
+void cowpi_set_pin_ISR_lockout(cowpi_pin_set_t interrupt_mask, uint8_t lockout_ms) {
+    if (lockout_ms) {
+        use_timer0_compb();
+    }
+    // the first period might end as soon as the lockout starts, so an extra period is needed for the full lockout
+    uint8_t periods = (lockout_ms < UINT8_MAX) ? lockout_ms + 1 : UINT8_MAX;
+    interrupt_mask &= 0xFFFFF;          // D0 -- D19
+    while (interrupt_mask) {
+        uint8_t pin = __builtin_ctzl(interrupt_mask);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            lockout_periods[pin] = periods;
+            if (lockout_ms) {
+                lockout_pins[COWPI_PIN_PORT(pin)] |= COWPI_PIN_MASK(pin);
+            } else {
+                lockout_pins[COWPI_PIN_PORT(pin)] &= ~COWPI_PIN_MASK(pin);
+            }
+        }
+        interrupt_mask &= interrupt_mask - 1;   // clear the lowest 1 bit
+    }
+}
+
+uint16_t cowpi_get_dropped_pin_events(uint8_t pin) {
+    uint16_t count = 0;
+    if (pin < 20) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            count = dropped_events[pin];
+        }
+    }
+    return count;
+}
+
+void cowpi_reset_dropped_pin_events(cowpi_pin_set_t interrupt_mask) {
+    interrupt_mask &= 0xFFFFF;          // D0 -- D19
+    while (interrupt_mask) {
+        uint8_t pin = __builtin_ctzl(interrupt_mask);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            dropped_events[pin] = 0;
+        }
+        interrupt_mask &= interrupt_mask - 1;   // clear the lowest 1 bit
+    }
+}
+
+// must be called from an ISR; `level` is the pin's value (its mask or 0) that its ISR was invoked for
+static void start_lockout(uint8_t pin, uint8_t io_bank, uint8_t pin_mask, uint8_t level) {
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    remaining_lockout_periods[pin] = lockout_periods[pin];
+    locked_pins[io_bank] |= pin_mask;
+    inputs[io_bank] = (inputs[io_bank] & ~pin_mask) | level;
+    sampled_inputs[io_bank] = (sampled_inputs[io_bank] & ~pin_mask) | level;
+    if (pin == 2 || pin == 3) {
+        pin_interrupts->ei_mask &= ~(1 << (pin - 2));
+    } else {
+        pin_interrupts->pci_mask[io_bank] &= ~pin_mask;
+    }
+    TIMSK0 |= 1 << 2;                   // OCIE0B
+}
+
+
+/* Coalescing */
+
+/*
+ * The dispatcher doesn't invoke an ISR for a coalesced pin; it only counts the pin's edges and sets its bit in
+ * coalesced_changes[]. When a coalesced ISR's window ends, take_coalesced_events() moves the counts for the ISR's pins
+ * into the events that the ISR is invoked with, starting the next window.
+ */
+
+bool cowpi_register_pin_coalesced_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges, uint16_t window_ms,
+                                      void (*isr)(cowpi_coalesced_pin_events_t const *events, void *context),
+                                      void *context) {
+    interrupt_mask &= 0xFFFFF;          // D0 -- D19
+    if (!interrupt_mask) {
+        return true;
+    }
+    // an entry whose pins are all being re-registered will become available
+    struct coalesced_pin_isr *coalesced_isr = NULL;
+    for (uint8_t i = 0; i < COALESCED_ISRS && !coalesced_isr; i++) {
+        if (!(coalesced_isrs[i].pins & ~interrupt_mask)) {
+            coalesced_isr = coalesced_isrs + i;
+        }
+    }
+    if (!coalesced_isr) {
+        return false;
+    }
+    // TIMER0's period is 1.024ms, so the window is 125/128 periods per millisecond, rounded
+    uint16_t window_periods = (uint16_t) (((uint32_t) window_ms * 125 + 64) / 128);
+    if (window_ms && !window_periods) {
+        window_periods = 1;
+    }
+    if (window_periods) {
+        use_timer0_compb();
+    }
+    set_isrs(interrupt_mask, (struct pin_isr) {.without_context = do_nothing}, false);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *coalesced_isr = (struct coalesced_pin_isr) {
+                .isr = isr,
+                .context = context,
+                .pins = interrupt_mask,
+                .window_periods = window_periods,
+                .remaining_window_periods = window_periods
+        };
+        coalesced_pins[COWPI_PD] |= PINS_IN_PD(interrupt_mask);
+        coalesced_pins[COWPI_PB] |= PINS_IN_PB(interrupt_mask);
+        coalesced_pins[COWPI_PC] |= PINS_IN_PC(interrupt_mask);
+        coalesced_changes[COWPI_PD] &= ~PINS_IN_PD(interrupt_mask);
+        coalesced_changes[COWPI_PB] &= ~PINS_IN_PB(interrupt_mask);
+        coalesced_changes[COWPI_PC] &= ~PINS_IN_PC(interrupt_mask);
+        cowpi_pin_set_t pins = interrupt_mask;
+        while (pins) {
+            edge_counts[__builtin_ctzl(pins)] = 0;
+            pins &= pins - 1;           // clear the lowest 1 bit
+        }
+        if (window_periods) {
+            TIMSK0 |= 1 << 2;           // OCIE0B
+        }
+    }
+    enable_interrupts(interrupt_mask, edges);
+    return true;
+}
+
+// must be called with interrupts disabled; `events` must be zeroed
+static void take_coalesced_events(struct coalesced_pin_isr const *coalesced_isr,
+                                  cowpi_coalesced_pin_events_t *events) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    cowpi_pin_set_t pins = coalesced_isr->pins;
+    cowpi_pin_set_t changes = ((cowpi_pin_set_t) coalesced_changes[COWPI_PD]
+                               | ((cowpi_pin_set_t) coalesced_changes[COWPI_PB] << 8)
+                               | ((cowpi_pin_set_t) coalesced_changes[COWPI_PC] << 14)) & pins;
+    events->changed_pins = changes;
+    events->inputs = ((cowpi_pin_set_t) ioports[COWPI_PD].input
+                      | ((cowpi_pin_set_t) (ioports[COWPI_PB].input & 0x3F) << 8)
+                      | ((cowpi_pin_set_t) (ioports[COWPI_PC].input & 0x3F) << 14)) & pins;
+    coalesced_changes[COWPI_PD] &= ~PINS_IN_PD(changes);
+    coalesced_changes[COWPI_PB] &= ~PINS_IN_PB(changes);
+    coalesced_changes[COWPI_PC] &= ~PINS_IN_PC(changes);
+    while (changes) {
+        uint8_t pin = __builtin_ctzl(changes);
+        events->edge_counts[pin] = edge_counts[pin];
+        edge_counts[pin] = 0;
+        changes &= changes - 1;         // clear the lowest 1 bit
+    }
+}
+
+void cowpi_service_coalesced_pin_ISRs(void) {
+    for (uint8_t i = 0; i < COALESCED_ISRS; i++) {
+        struct coalesced_pin_isr const *coalesced_isr = coalesced_isrs + i;
+        cowpi_coalesced_pin_events_t events = {0};
+        void (*isr)(cowpi_coalesced_pin_events_t const *events, void *context) = NULL;
+        void *context = NULL;
+        // only the events are taken with interrupts disabled; the ISR is invoked with interrupts enabled
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (coalesced_isr->pins && !coalesced_isr->window_periods) {
+                take_coalesced_events(coalesced_isr, &events);
+                isr = coalesced_isr->isr;
+                context = coalesced_isr->context;
             }
         }
-    } while (++i < 32);
-    PCICR = 0x7;    // re-enable pin change interrupts
-}
-
-#define RUN_ISR(first_pin, last_pin, io_bank, new_inputs) do {  \
-  uint8_t change = (new_inputs) ^ inputs[(io_bank)];            \
-  int8_t i = (first_pin);                                       \
-  switch (change) {                                             \
-    case 0x01:                                                  \
-      interrupt_service_routines[(first_pin) + 0]();            \
-      break;                                                    \
-    case 0x02:                                                  \
-      interrupt_service_routines[(first_pin) + 1]();            \
-      break;                                                    \
-    case 0x04:                                                  \
-      interrupt_service_routines[(first_pin) + 2]();            \
-      break;                                                    \
-    case 0x08:                                                  \
-      interrupt_service_routines[(first_pin) + 3]();            \
-      break;                                                    \
-    case 0x10:                                                  \
-      interrupt_service_routines[(first_pin) + 4]();            \
-      break;                                                    \
-    case 0x20:                                                  \
-      interrupt_service_routines[(first_pin) + 5]();            \
-      break;                                                    \
-    case 0x40:                                                  \
-      interrupt_service_routines[(first_pin) + 6]();            \
-      break;                                                    \
-    case 0x80:                                                  \
-      interrupt_service_routines[(first_pin) + 7]();            \
-      break;                                                    \
-    default:                                                    \
-      do {                                                      \
-        if (change & 0x1) {                                     \
-          interrupt_service_routines[i]();                      \
-        }                                                       \
-        change >>= 1;                                           \
-        i++;                                                    \
-      } while (i <= (last_pin));                                \
-  }                                                             \
-  inputs[(io_bank)] = (new_inputs);                             \
-} while (0)
-
-ISR(PCINT0_vect) {  // handle pin change interrupt for D8 to D13 here
-        RUN_ISR(8, 13, 0, PINB & PCMSK0);
-}
-
-ISR(PCINT1_vect) {  // handle pin change interrupt for D14 to D19 here
-        RUN_ISR(14, 19, 1, PINC & PCMSK1);
-}
-
-ISR(PCINT2_vect) {  // handle pin change interrupt for D0 to D7 here
-        RUN_ISR(0, 7, 2, PIND & PCMSK2);
+        if (isr) {
+            isr(&events, context);
+        }
+    }
+}
+
+// must be called from an ISR; returns whether any coalesced ISR is invoked from TIMER0
+static bool run_timed_coalesced_isrs(void) {
+    bool windows_are_timed = false;
+    for (uint8_t i = 0; i < COALESCED_ISRS; i++) {
+        struct coalesced_pin_isr *coalesced_isr = coalesced_isrs + i;
+        if (!coalesced_isr->pins || !coalesced_isr->window_periods) {
+            continue;
+        }
+        windows_are_timed = true;
+        if (!--coalesced_isr->remaining_window_periods) {
+            coalesced_isr->remaining_window_periods = coalesced_isr->window_periods;
+            cowpi_coalesced_pin_events_t events = {0};
+            take_coalesced_events(coalesced_isr, &events);
+            coalesced_isr->isr(&events, coalesced_isr->context);
+        }
+    }
+    return windows_are_timed;
+}
+
+
+/* Encoders */
+
+/*
+ * An encoder's pins are enabled for pin change interrupts (or, for D2 and D3, external interrupts on both edges) but
+ * have no edges registered, so the dispatcher never invokes an ISR for them. Instead, the vectors decode the encoders
+ * with an output in their I/O bank before dispatching: the previous and current A:B values index a table of steps, and
+ * a transition in which both outputs changed is illegal.
+ */
+
+#define ILLEGAL_TRANSITION 2
+
+// indexed by the previous A:B and the current A:B; A leading B is the positive direction
+static int8_t const quadrature_steps[16] PROGMEM = {
+        0,                  -1,                 +1,                 ILLEGAL_TRANSITION,
+        +1,                 0,                  ILLEGAL_TRANSITION, -1,
+        -1,                 ILLEGAL_TRANSITION, 0,                  +1,
+        ILLEGAL_TRANSITION, +1,                 -1,                 0
+};
+
+static inline __attribute__ ((always_inline)) uint8_t read_encoder(struct encoder const *encoder) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    return ((ioports[encoder->a_bank].input & encoder->a_mask) ? 0x2 : 0x0)
+           | ((ioports[encoder->b_bank].input & encoder->b_mask) ? 0x1 : 0x0);
+}
+
+bool cowpi_register_encoder(uint8_t encoder, uint8_t a_pin, uint8_t b_pin) {
+    if (encoder >= COWPI_MAX_ENCODERS || a_pin >= 20 || b_pin >= 20 || a_pin == b_pin) {
+        return false;
+    }
+    cowpi_pin_set_t pins = COWPI_PIN_SET(a_pin) | COWPI_PIN_SET(b_pin);
+    cowpi_deregister_encoder(encoder);
+    // this also deregisters any other encoder using the pins
+    cowpi_deregister_pin_ISR(pins);
+    struct encoder *new_encoder = encoders + encoder;
+    // the encoder must be in place before its pins' interrupts are enabled
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        new_encoder->a_pin = a_pin;
+        new_encoder->b_pin = b_pin;
+        new_encoder->a_bank = COWPI_PIN_PORT(a_pin);
+        new_encoder->b_bank = COWPI_PIN_PORT(b_pin);
+        new_encoder->a_mask = COWPI_PIN_MASK(a_pin);
+        new_encoder->b_mask = COWPI_PIN_MASK(b_pin);
+        new_encoder->state = read_encoder(new_encoder);
+        new_encoder->position = 0;
+        new_encoder->illegal_transitions = 0;
+        encoders_in_use |= 1 << encoder;
+        encoder_pins[new_encoder->a_bank] |= new_encoder->a_mask;
+        encoder_pins[new_encoder->b_bank] |= new_encoder->b_mask;
+        encoders_in_bank[new_encoder->a_bank] |= 1 << encoder;
+        encoders_in_bank[new_encoder->b_bank] |= 1 << encoder;
+    }
+    if (pins & COWPI_PIN_SET(2)) {
+        enable_external_interrupt(2, COWPI_BOTH_EDGES);
+    }
+    if (pins & COWPI_PIN_SET(3)) {
+        enable_external_interrupt(3, COWPI_BOTH_EDGES);
+    }
+    enable_pins(COWPI_PD, PINS_IN_PD(pins & ~EXTERNAL_INTERRUPT_PINS), 0);
+    enable_pins(COWPI_PB, PINS_IN_PB(pins), 0);
+    enable_pins(COWPI_PC, PINS_IN_PC(pins), 0);
+    return true;
+}
+
+void cowpi_deregister_encoder(uint8_t encoder) {
+    if (encoder < COWPI_MAX_ENCODERS && (encoders_in_use & (1 << encoder))) {
+        cowpi_deregister_pin_ISR(COWPI_PIN_SET(encoders[encoder].a_pin) | COWPI_PIN_SET(encoders[encoder].b_pin));
+    }
+}
+
+int32_t cowpi_get_encoder_position(uint8_t encoder) {
+    int32_t position = 0;
+    if (encoder < COWPI_MAX_ENCODERS) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            position = encoders[encoder].position;
+        }
+    }
+    return position;
+}
+
+void cowpi_set_encoder_position(uint8_t encoder, int32_t position) {
+    if (encoder < COWPI_MAX_ENCODERS) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            encoders[encoder].position = position;
+        }
+    }
+}
+
+uint16_t cowpi_get_encoder_illegal_transitions(uint8_t encoder) {
+    uint16_t count = 0;
+    if (encoder < COWPI_MAX_ENCODERS) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            count = encoders[encoder].illegal_transitions;
+        }
+    }
+    return count;
+}
+
+void cowpi_reset_encoder_illegal_transitions(uint8_t encoder) {
+    if (encoder < COWPI_MAX_ENCODERS) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            encoders[encoder].illegal_transitions = 0;
+        }
+    }
+}
+
+// must be called from an ISR
+static inline __attribute__ ((always_inline)) void decode_encoders(uint8_t io_bank) {
+    uint8_t pending = encoders_in_bank[io_bank];
+    while (pending) {
+        struct encoder *encoder = encoders + pgm_read_byte(lowest_set_bit + pending);
+        uint8_t state = read_encoder(encoder);
+        int8_t step = (int8_t) pgm_read_byte(quadrature_steps + ((encoder->state << 2) | state));
+        encoder->state = state;
+        if (step != ILLEGAL_TRANSITION) {
+            encoder->position += step;
+        } else if (encoder->illegal_transitions < UINT16_MAX) {
+            encoder->illegal_transitions++;
+        }
+        pending &= pending - 1;         // clear the lowest 1 bit
+    }
+}
+
+
+/* Dispatching */
+
+/*
+ * Only the pins that changed in a direction that their ISRs are registered for are dispatched, lowest pin first. Each
+ * dispatch takes a constant number of cycles: the lowest remaining pin is found with a table lookup, and then it is
+ * cleared, instead of shifting through the bits that didn't change. An ISR that takes a context is also given its pin
+ * and the direction of the change, which are already known here.
+ */
+static inline __attribute__ ((always_inline)) void count_edges(uint8_t first_pin, uint8_t io_bank, uint8_t pins) {
+    coalesced_changes[io_bank] |= pins;
+    while (pins) {
+        uint8_t pin = first_pin + pgm_read_byte(lowest_set_bit + pins);
+        if (edge_counts[pin] < UINT16_MAX) {
+            edge_counts[pin]++;
+        }
+        pins &= pins - 1;           // clear the lowest 1 bit
+    }
+}
+
+static inline __attribute__ ((always_inline)) void run_isrs(uint8_t first_pin, uint8_t io_bank, uint8_t new_inputs) {
+    // a locked-out pin's PCMSKx bit is clear, so it keeps the value that its ISR was invoked for
+    new_inputs |= inputs[io_bank] & locked_pins[io_bank];
+    uint8_t changes = new_inputs ^ inputs[io_bank];
+    inputs[io_bank] = new_inputs;
+    uint8_t pending = (changes & new_inputs & rising_edge_pins[io_bank])
+                      | (changes & ~new_inputs & falling_edge_pins[io_bank]);
+    uint8_t coalesced = pending & coalesced_pins[io_bank];
+    if (coalesced) {
+        count_edges(first_pin, io_bank, coalesced);
+        pending &= ~coalesced;
+    }
+    uint8_t pins_with_context = context_pins[io_bank];
+    uint8_t pins_with_lockout = lockout_pins[io_bank];
+    while (pending) {
+        uint8_t pin = first_pin + pgm_read_byte(lowest_set_bit + pending);
+        uint8_t pin_mask = pending & -pending;      // only the lowest 1 bit
+        struct pin_isr const *isr = interrupt_service_routines + pin;
+        if (pins_with_context & pin_mask) {
+            isr->with_context(pin, (new_inputs & pin_mask) ? COWPI_RISING_EDGE : COWPI_FALLING_EDGE, isr->context);
+        } else {
+            isr->without_context();
+        }
+        if (pins_with_lockout & pin_mask) {
+            start_lockout(pin, io_bank, pin_mask, new_inputs & pin_mask);
+        }
+        pending &= pending - 1;     // clear the lowest 1 bit
+    }
+}
+
+/*
+ * An external interrupt that fires on only one edge is known to be that edge; otherwise, the pin's value is the edge's
+ * destination.
+ */
+static inline __attribute__ ((always_inline)) cowpi_pin_edge_t get_external_interrupt_edge(uint8_t pin) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    // ISCx1:ISCx0 -- 01 = any change, 10 = falling edge, 11 = rising edge
+    uint8_t sense = (pin_interrupts->ei_control >> (2 * (pin - 2))) & 0x3;
+    return (sense == 0x2) ? COWPI_FALLING_EDGE
+           : (sense == 0x3) ? COWPI_RISING_EDGE
+           : (ioports[COWPI_PD].input & COWPI_PIN_MASK(pin)) ? COWPI_RISING_EDGE
+           : COWPI_FALLING_EDGE;
+}
+
+static inline __attribute__ ((always_inline)) void run_external_isr(uint8_t pin) {
+    struct pin_isr const *isr = interrupt_service_routines + pin;
+    uint8_t pin_mask = COWPI_PIN_MASK(pin);
+    if (coalesced_pins[COWPI_PD] & pin_mask) {
+        count_edges(0, COWPI_PD, pin_mask);
+        return;
+    }
+    if (context_pins[COWPI_PD] & pin_mask) {
+        isr->with_context(pin, get_external_interrupt_edge(pin), isr->context);
+    } else {
+        isr->without_context();
+    }
+    if (lockout_pins[COWPI_PD] & pin_mask) {
+        start_lockout(pin, COWPI_PD, pin_mask, (get_external_interrupt_edge(pin) == COWPI_RISING_EDGE) ? pin_mask : 0);
+    }
+}
+
+/*
+ * The edges during an external interrupt's lockout are discarded, but if they left the pin with a different value than
+ * the one that its ISR was invoked for, then that change is dispatched.
+ */
+static void end_external_lockout(uint8_t pin) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    uint8_t pin_mask = COWPI_PIN_MASK(pin);
+    uint8_t interrupt_bit = 1 << (pin - 2);
+    uint8_t new_input = ioports[COWPI_PD].input & pin_mask;
+    uint8_t old_input = inputs[COWPI_PD] & pin_mask;
+    inputs[COWPI_PD] &= ~pin_mask;
+    pin_interrupts->ei_flags = interrupt_bit;       // write a 1 to *only* the relevant EIFR bit
+    pin_interrupts->ei_mask |= interrupt_bit;
+    if ((new_input & ~old_input & rising_edge_pins[COWPI_PD])
+        | (~new_input & old_input & falling_edge_pins[COWPI_PD])) {
+        run_external_isr(pin);
+    }
+}
+
+// must be called from an ISR
+static void end_lockouts(uint8_t io_bank, uint8_t pins) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    cowpi_pininterrupt_t volatile *pin_interrupts = (cowpi_pininterrupt_t *) (COWPI_IO_BASE + 0x1B);
+    locked_pins[io_bank] &= ~pins;
+    if (io_bank == COWPI_PD) {
+        if (pins & COWPI_PIN_MASK(2)) {
+            end_external_lockout(2);
+        }
+        if (pins & COWPI_PIN_MASK(3)) {
+            end_external_lockout(3);
+        }
+        pins &= ~(COWPI_PIN_MASK(2) | COWPI_PIN_MASK(3));
+    }
+    if (pins) {
+        pin_interrupts->pci_mask[io_bank] |= pins;
+        // if the pins changed during the lockout, then dispatch the changes that they left behind
+        run_isrs(first_pins[io_bank], io_bank, ioports[io_bank].input & pin_interrupts->pci_mask[io_bank]);
+    }
+}
+
+/*
+ * Each change in a locked-out pin's sampled value that its ISR is registered for is counted as a dropped event, except
+ * for a change that is left behind when the lockout ends, which is dispatched instead. Changes between samples cannot
+ * be seen, so the count is a lower bound. After the lockouts, the coalescing windows that are timed by TIMER0 are
+ * advanced.
+ */
+static void service_lockouts_and_windows(void) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    bool pins_are_locked = false;
+    for (uint8_t io_bank = COWPI_PB; io_bank <= COWPI_PD; io_bank++) {
+        uint8_t pins = locked_pins[io_bank];
+        if (!pins) {
+            continue;
+        }
+        uint8_t new_inputs = ioports[io_bank].input;
+        uint8_t changes = (new_inputs ^ sampled_inputs[io_bank]) & pins;
+        uint8_t dropped = (changes & new_inputs & rising_edge_pins[io_bank])
+                          | (changes & ~new_inputs & falling_edge_pins[io_bank]);
+        uint8_t left_behind = ((new_inputs & ~inputs[io_bank] & rising_edge_pins[io_bank])
+                               | (~new_inputs & inputs[io_bank] & falling_edge_pins[io_bank])) & pins;
+        sampled_inputs[io_bank] = new_inputs;
+        uint8_t ended = 0;
+        while (pins) {
+            uint8_t pin = first_pins[io_bank] + pgm_read_byte(lowest_set_bit + pins);
+            uint8_t pin_mask = pins & -pins;            // only the lowest 1 bit
+            int8_t count = (dropped & pin_mask) ? 1 : 0;
+            if (!--remaining_lockout_periods[pin]) {
+                ended |= pin_mask;
+                // the change that is left behind will be dispatched, and it was counted when it was sampled
+                count -= (left_behind & pin_mask) ? 1 : 0;
+            }
+            if (count > 0 && dropped_events[pin] < UINT16_MAX) {
+                dropped_events[pin]++;
+            } else if (count < 0 && dropped_events[pin] > 0) {
+                dropped_events[pin]--;
+            }
+            pins &= pins - 1;           // clear the lowest 1 bit
+        }
+        if (ended) {
+            end_lockouts(io_bank, ended);
+        }
+        // a dispatched change might have started a new lockout
+        pins_are_locked = pins_are_locked || locked_pins[io_bank];
+    }
+    bool windows_are_timed = run_timed_coalesced_isrs();
+    if (!pins_are_locked && !windows_are_timed) {
+        TIMSK0 &= ~(1 << 2);            // OCIE0B
+    }
+}
+
+/*
+ * The vector is weak so that a program can define its own, and it reaches the lockouts and coalescing windows only
+ * through a pointer that is set when they are first used, so that a program that binds its own pin ISRs and uses
+ * neither doesn't link the dispatcher and its table.
+ */
+ISR(TIMER0_COMPB_vect, __attribute__ ((weak))) {
+    if (timer0_compb_handler) {
+        timer0_compb_handler();
+    } else {
+        TIMSK0 &= ~(1 << 2);            // OCIE0B
+    }
+}
+
+/*
+ * The vectors are weak so that a program that binds its own ISRs with COWPI_BIND_PIN_ISRS() replaces them; unless that
+ * program also calls cowpi_register_pin_ISR() or another registration function, the table isn't linked.
+ */
+ISR(INT0_vect, __attribute__ ((weak))) {    // handle external interrupt for D2 here
+    if (encoder_pins[COWPI_PD] & COWPI_PIN_MASK(2)) {
+        decode_encoders(COWPI_PD);
+    } else {
+        run_external_isr(2);
+    }
+}
+
+ISR(INT1_vect, __attribute__ ((weak))) {    // handle external interrupt for D3 here
+    if (encoder_pins[COWPI_PD] & COWPI_PIN_MASK(3)) {
+        decode_encoders(COWPI_PD);
+    } else {
+        run_external_isr(3);
+    }
+}
+
+/*
+ * The encoders are decoded before any ISR is dispatched, so that their latency is as low as possible. An encoder
+ * output's pin has no edges registered, so the dispatcher doesn't invoke an ISR for it.
+ */
+ISR(PCINT0_vect, __attribute__ ((weak))) {  // handle pin change interrupt for D8 to D13 here
+    decode_encoders(COWPI_PB);
+    run_isrs(8, COWPI_PB, PINB & PCMSK0);
+}
+
+ISR(PCINT1_vect, __attribute__ ((weak))) {  // handle pin change interrupt for D14 to D19 here
+    decode_encoders(COWPI_PC);
+    run_isrs(14, COWPI_PC, PINC & PCMSK1);
+}
+
+ISR(PCINT2_vect, __attribute__ ((weak))) {  // handle pin change interrupt for D0 to D7 here
+    decode_encoders(COWPI_PD);
+    run_isrs(0, COWPI_PD, PIND & PCMSK2);
 }
 
 #endif // ARDUINO_AVR_UNO || ARDUINO_AVR_NANO
\ No newline at end of file
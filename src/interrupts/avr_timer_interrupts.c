@@ -44,7 +44,6 @@ struct timer_data {
     uint8_t ctc_mode_bits[2];
     uint8_t clock_select_bits[2][NUMBER_OF_PRESCALERS];
     uint8_t number_of_isr_slots;
-    void (*interrupt_service_routines[3])(void);
 };
 
 static struct timer_data timers[] = {
@@ -56,7 +55,6 @@ static struct timer_data timers[] = {
                 .clock_select_bits = {{0},
                                       {1, 2, 3, 4, 5, 0, 0}},
                 .number_of_isr_slots = 0,
-                .interrupt_service_routines = {do_nothing, do_nothing, do_nothing},
         },
         {
                 .prescalers = {1, 8, 64, 256, 1024, 0, 0},
@@ -66,7 +64,6 @@ static struct timer_data timers[] = {
                 .clock_select_bits = {{0},
                                       {1, 2, 3, 4, 5, 0, 0}},
                 .number_of_isr_slots = 0,
-                .interrupt_service_routines = {do_nothing, do_nothing, do_nothing},
         },
         {
                 .prescalers = {1, 8, 32, 64, 128, 256, 1024},
@@ -76,32 +73,63 @@ static struct timer_data timers[] = {
                 .clock_select_bits = {{0},
                                       {1, 2, 3, 4, 5, 6, 7}},
                 .number_of_isr_slots = 0,
-                .interrupt_service_routines = {do_nothing, do_nothing, do_nothing},
         }
 };
 
-ISR(TIMER1_OVF_vect) {
-        timers[1].interrupt_service_routines[0]();
+/*
+ * The ISRs are kept apart from the timers' configuration data, and the vectors are weak, so that a program that binds
+ * its own ISRs with COWPI_BIND_TIMER_ISRS() replaces the vectors and, unless it also calls register_periodic_ISR(),
+ * doesn't link the table.
+ */
+struct timer_isr {
+    union {
+        void (*without_context)(void);
+        void (*with_context)(void *context);
+    };
+    void *context;
+};
+
+// indexed by the timer number and the vector (TIMSKx bit position)
+static struct timer_isr interrupt_service_routines[3][3] = {
+        {{.without_context = do_nothing}, {.without_context = do_nothing}, {.without_context = do_nothing}},
+        {{.without_context = do_nothing}, {.without_context = do_nothing}, {.without_context = do_nothing}},
+        {{.without_context = do_nothing}, {.without_context = do_nothing}, {.without_context = do_nothing}}
+};
+
+// indexed by the timer number, the vectors (TIMSKx bit positions) whose ISRs take a context
+static uint8_t volatile context_isrs[3];
+
+static inline __attribute__ ((always_inline)) void run_isr(uint8_t timer_number, uint8_t vector) {
+    struct timer_isr const *isr = &interrupt_service_routines[timer_number][vector];
+    if (context_isrs[timer_number] & (1 << vector)) {
+        isr->with_context(isr->context);
+    } else {
+        isr->without_context();
+    }
+}
+
+ISR(TIMER1_OVF_vect, __attribute__ ((weak))) {
+        run_isr(1, 0);
 }
 
-ISR(TIMER1_COMPA_vect) {
-        timers[1].interrupt_service_routines[1]();
+ISR(TIMER1_COMPA_vect, __attribute__ ((weak))) {
+        run_isr(1, 1);
 }
 
-ISR(TIMER1_COMPB_vect) {
-        timers[1].interrupt_service_routines[2]();
+ISR(TIMER1_COMPB_vect, __attribute__ ((weak))) {
+        run_isr(1, 2);
 }
 
-ISR(TIMER2_OVF_vect) {
-        timers[2].interrupt_service_routines[0]();
+ISR(TIMER2_OVF_vect, __attribute__ ((weak))) {
+        run_isr(2, 0);
 }
 
-ISR(TIMER2_COMPA_vect) {
-        timers[2].interrupt_service_routines[1]();
+ISR(TIMER2_COMPA_vect, __attribute__ ((weak))) {
+        run_isr(2, 1);
 }
 
-ISR(TIMER2_COMPB_vect) {
-        timers[2].interrupt_service_routines[2]();
+ISR(TIMER2_COMPB_vect, __attribute__ ((weak))) {
+        run_isr(2, 2);
 }
 
 float configure_timer(unsigned int timer_number, float desired_period_us) {
@@ -112,10 +140,8 @@ float configure_timer(unsigned int timer_number, float desired_period_us) {
     if (desired_period_us < 1) {
         return INFINITY;
     }
+    // the previous ISRs are deregistered by clearing TIMSKx; register_periodic_ISR() replaces them before re-enabling
     struct timer_data *timer = timers + timer_number;
-    timer->interrupt_service_routines[0] = do_nothing;
-    timer->interrupt_service_routines[1] = do_nothing;
-    timer->interrupt_service_routines[2] = do_nothing;
     float const system_clock = 16.0f;   // cycles per microsecond
     float best_error = INFINITY;
     float best_period = INFINITY;
@@ -183,7 +209,7 @@ float configure_timer(unsigned int timer_number, float desired_period_us) {
     return best_period;
 }
 
-bool register_periodic_ISR(unsigned int timer_number, unsigned int isr_slot, void (*isr)(void)) {
+static bool register_isr(unsigned int timer_number, unsigned int isr_slot, struct timer_isr isr, bool has_context) {
     struct timer_data *timer = timers + timer_number;
     uint8_t number_of_isr_slots = timer->number_of_isr_slots;
     if (timer_number < 1 || timer_number > 2) {
@@ -197,7 +223,15 @@ bool register_periodic_ISR(unsigned int timer_number, unsigned int isr_slot, voi
         // number_of_isr_slots==2 iff the timer is in CTC mode, which means we cannot use TIMERx_OVF_VECT
         isr_slot++;
     }
-    timer->interrupt_service_routines[isr_slot] = isr;
+    // the ISR might be running for this slot, so don't let it see a half-written ISR
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        interrupt_service_routines[timer_number][isr_slot] = isr;
+        if (has_context) {
+            context_isrs[timer_number] |= 1 << isr_slot;
+        } else {
+            context_isrs[timer_number] &= ~(1 << isr_slot);
+        }
+    }
     switch(timer_number) {
         case 1:
             TIMSK1 |= 1 << isr_slot;
@@ -212,6 +246,15 @@ bool register_periodic_ISR(unsigned int timer_number, unsigned int isr_slot, voi
     return true;
 }
 
+bool register_periodic_ISR(unsigned int timer_number, unsigned int isr_slot, void (*isr)(void)) {
+    return register_isr(timer_number, isr_slot, (struct timer_isr) {.without_context = isr}, false);
+}
+
+bool register_periodic_context_ISR(unsigned int timer_number, unsigned int isr_slot, void (*isr)(void *context),
+                                   void *context) {
+    return register_isr(timer_number, isr_slot, (struct timer_isr) {.with_context = isr, .context = context}, true);
+}
+
 void reset_timer(unsigned int timer_number) {
     // for now, we'll prohibit TIMER0 and assume only TIMER1 & TIMER2 exist -- later we can do uc-specific values
     switch(timer_number) {
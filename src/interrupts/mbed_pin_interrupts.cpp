@@ -36,9 +36,9 @@
 extern "C" {
 #endif
 
-extern uint32_t cowpi_floating_input_pins;
-extern uint32_t cowpi_pullup_input_pins;
-extern uint32_t cowpi_pulldown_input_pins;
+extern cowpi_pin_set_t cowpi_floating_input_pins;
+extern cowpi_pin_set_t cowpi_pullup_input_pins;
+extern cowpi_pin_set_t cowpi_pulldown_input_pins;
 
 static mbed::InterruptIn *inputs[32] = {
         nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
@@ -47,38 +47,87 @@ static mbed::InterruptIn *inputs[32] = {
         nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
 };
 
-void cowpi_register_pin_ISR(uint32_t interrupt_mask, void (*isr)(void)) {
+void cowpi_register_pin_ISR(cowpi_pin_set_t interrupt_mask, void (*isr)(void)) {
+    cowpi_register_pin_edge_ISR(interrupt_mask, COWPI_BOTH_EDGES, isr);
+}
+
+// the pin's InterruptIn, created if necessary, with the pin's mode
+static mbed::InterruptIn *get_input(int8_t i) {
+    PinMode mode;
+    if (cowpi_floating_input_pins & COWPI_PIN_SET(i)) {
+        mode = PullNone;
+    } else if (cowpi_pullup_input_pins & COWPI_PIN_SET(i)) {
+        mode = PullUp;
+    } else if (cowpi_pulldown_input_pins & COWPI_PIN_SET(i)) {
+        mode = PullDown;
+    } else {
+        // pin wasn't configured with cowpi_set_xxx_input_pins(), so we don't know what the mode should be
+        mode = PullDefault;
+    }
+    if (inputs[i] == nullptr) {
+        inputs[i] = new mbed::InterruptIn((PinName) i, mode);
+    } else {
+        inputs[i]->mode(mode);
+    }
+    return inputs[i];
+}
+
+void cowpi_register_pin_edge_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges, void (*isr)(void)) {
+    int8_t i = 0;
+    do {
+        if (interrupt_mask & COWPI_PIN_SET(i)) {
+            mbed::InterruptIn *input = get_input(i);
+            input->disable_irq();   // disable interrupts while we're making changes
+            input->rise((edges & COWPI_RISING_EDGE) ? isr : NULL);
+            input->fall((edges & COWPI_FALLING_EDGE) ? isr : NULL);
+            input->enable_irq();   // re-enable interrupts
+        }
+    } while (++i < 32);
+}
+
+struct pin_context {
+    void (*isr)(uint8_t pin, cowpi_pin_edge_t edge, void *context);
+    void *context;
+    uint8_t pin;
+};
+
+static struct pin_context contexts[32];
+
+static void run_rising_edge_isr(struct pin_context *pin_context) {
+    pin_context->isr(pin_context->pin, COWPI_RISING_EDGE, pin_context->context);
+}
+
+static void run_falling_edge_isr(struct pin_context *pin_context) {
+    pin_context->isr(pin_context->pin, COWPI_FALLING_EDGE, pin_context->context);
+}
+
+void cowpi_register_pin_context_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges,
+                                    void (*isr)(uint8_t pin, cowpi_pin_edge_t edge, void *context), void *context) {
     int8_t i = 0;
     do {
-        if (interrupt_mask & (1L << i)) {
-            PinMode mode;
-            if (cowpi_floating_input_pins & (1L << i)) {
-                mode = PullNone;
-            } else if (cowpi_pullup_input_pins & (1L << i)) {
-                mode = PullUp;
-            } else if (cowpi_pulldown_input_pins & (1L << i)) {
-                mode = PullDown;
+        if (interrupt_mask & COWPI_PIN_SET(i)) {
+            mbed::InterruptIn *input = get_input(i);
+            input->disable_irq();   // disable interrupts while we're making changes
+            contexts[i] = (struct pin_context) {.isr = isr, .context = context, .pin = (uint8_t) i};
+            if (edges & COWPI_RISING_EDGE) {
+                input->rise(mbed::callback(run_rising_edge_isr, contexts + i));
             } else {
-                // pin wasn't configured with cowpi_set_xxx_input_pins(), so we don't know what the mode should be
-                mode = PullDefault;
+                input->rise(NULL);
             }
-            if (inputs[i] == nullptr) {
-                inputs[i] = new mbed::InterruptIn((PinName) i, mode);
+            if (edges & COWPI_FALLING_EDGE) {
+                input->fall(mbed::callback(run_falling_edge_isr, contexts + i));
             } else {
-                inputs[i]->mode(mode);
+                input->fall(NULL);
             }
-            inputs[i]->disable_irq();   // disable interrupts while we're making changes
-            inputs[i]->rise(isr);
-            inputs[i]->fall(isr);
-            inputs[i]->enable_irq();   // re-enable interrupts
+            input->enable_irq();   // re-enable interrupts
         }
     } while (++i < 32);
 }
 
-void cowpi_deregister_pin_ISR(uint32_t interrupt_mask) {
+void cowpi_deregister_pin_ISR(cowpi_pin_set_t interrupt_mask) {
     int8_t i = 0;
     do {
-        if (interrupt_mask & (1L << i)) {
+        if (interrupt_mask & COWPI_PIN_SET(i)) {
             if (inputs[i] != nullptr) {
                 inputs[i]->disable_irq();   // disable interrupts while we're making changes
                 inputs[i]->rise(NULL);
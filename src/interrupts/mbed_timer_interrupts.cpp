@@ -52,7 +52,7 @@ extern "C" {
 struct timer_data {
     mbed::Ticker *ticker;
     std::chrono::microseconds period;
-    void (*interrupt_service_routine)(void);
+    mbed::Callback<void()> interrupt_service_routine;
 };
 
 static std::chrono::microseconds constexpr no_time = std::chrono::microseconds(0);
@@ -68,7 +68,7 @@ static struct timer_data timers[MAXIMUM_NUMBER_OF_TIMERS] = {
         {.ticker = nullptr, .period = no_time, .interrupt_service_routine = nullptr,}
 };
 
-bool register_timer_ISR(unsigned int timer_number, uint32_t period_us, void (*isr)(void)) {
+static bool register_isr(unsigned int timer_number, uint32_t period_us, mbed::Callback<void()> isr) {
     if (timer_number >= MAXIMUM_NUMBER_OF_TIMERS) {
         return false;
     }
@@ -86,6 +86,15 @@ bool register_timer_ISR(unsigned int timer_number, uint32_t period_us, void (*is
     return true;
 }
 
+bool register_periodic_ISR(unsigned int timer_number, uint32_t period_us, void (*isr)(void)) {
+    return register_isr(timer_number, period_us, isr);
+}
+
+bool register_periodic_context_ISR(unsigned int timer_number, uint32_t period_us, void (*isr)(void *context),
+                                   void *context) {
+    return register_isr(timer_number, period_us, mbed::callback(isr, context));
+}
+
 void reset_timer(unsigned int timer_number) {
     if (timer_number >= MAXIMUM_NUMBER_OF_TIMERS) {
         return;
@@ -9,10 +9,9 @@
  *
  * Provides functions to register and deregister functions to handle to
  * interrupts that are fired due to changes on the microcontroller's pins.
- * A function specific to each pin (or combination of pins) can be registered.
- * There is no option for only-rising or only-falling interrupt handlers; the
- * same function must service all changes on the pin(s) that it is registered
- * to service.
+ * A function specific to each pin (or combination of pins) can be registered,
+ * either for every change on the pin(s) or for only rising edges or only
+ * falling edges.
  *
  ******************************************************************************/
 
@@ -32,41 +31,125 @@
 #ifndef COWPI_PIN_INTERRUPTS_H
 #define COWPI_PIN_INTERRUPTS_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include "../setup/pin_set.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief The direction(s) of logic-level changes that an interrupt handler
+ * services.
+ */
+typedef enum {
+    COWPI_RISING_EDGE = 0x1,            //!< Low-to-high changes
+    COWPI_FALLING_EDGE = 0x2,           //!< High-to-low changes
+    COWPI_BOTH_EDGES = 0x3              //!< Low-to-high and high-to-low changes
+} cowpi_pin_edge_t;
+
 /**
  * @brief Registers a function to service pin-based interrupts triggered by
  * logic-level changes on one or more pins.
  *
  * The registered function will be invoked whenever there is a low-to-high or
  * a high-to-low change. If behavior is only required for a rising edge or for
- * a falling edge, or if the behavior for rising and falling edges must
- * differ, then the function should have a conditional to determine the
- * direction of the change.
+ * a falling edge, then use `cowpi_register_pin_edge_ISR()` instead. If the
+ * behavior for rising and falling edges must differ, then the function should
+ * have a conditional to determine the direction of the change.
  *
  * If the change is generated by a mechanical device, then the isr function is
  * responsible for debouncing if there is not a hardware debouncing circuit.
  *
  * The <code>interrupt_mask</code> argument is used to specify which pins will
  * be serviced by the registered function. Bit0 corresponds to Pin 0, Bit1
- * corresponds to Pin 1, and so on. A 1 in a particular bit indicates that the
- * function is to be registered for changes on the corresponding pin. If more
- * than one bit has a 1, then the function will be registered for each of the
- * corresponding pins. If there previously was a function registered to handle
- * changes on a specified pin, then the new function will replace the old
- * function. A bit with a 0 signifies nothing more than that the function is
- * not being registered to service changes on that pin at this time.
+ * corresponds to Pin 1, and so on (see `COWPI_PIN_SET()`). A 1 in a particular
+ * bit indicates that the function is to be registered for changes on the
+ * corresponding pin. If more than one bit has a 1, then the function will be
+ * registered for each of the corresponding pins. If there previously was a
+ * function registered to handle changes on a specified pin, then the new
+ * function will replace the old function. A bit with a 0 signifies nothing more
+ * than that the function is not being registered to service changes on that pin
+ * at this time.
+ *
+ * Registering a function does not interrupt the servicing of changes on other
+ * pins. On the ATmega328P, interrupts are disabled only briefly while each
+ * affected I/O bank is updated, and a change on another pin during that time
+ * is serviced afterward instead of being lost.
+ *
+ * On the Arduino Uno and Arduino Nano, pins D2 and D3 are serviced by the
+ * dedicated external interrupts INT0 and INT1, which select the edges in
+ * hardware and have lower latency than the pin change interrupts used for the
+ * other pins. Latency-critical inputs should be connected to D2 or D3.
+ *
+ * @param interrupt_mask A bit vector specifying which pins will be serviced by
+ *      the registered ISR
+ * @param isr The function that will service interrupts triggered by changes on
+ *      the specified pins
+ */
+void cowpi_register_pin_ISR(cowpi_pin_set_t interrupt_mask, void (*isr)(void));
+
+/**
+ * @brief Registers a function to service pin-based interrupts triggered by
+ * rising edges, falling edges, or both on one or more pins.
+ *
+ * This function is the same as `cowpi_register_pin_ISR()`, except that the
+ * registered function will be invoked only for the specified edges. For
+ * example, a function that responds to a button being pressed (pulling its pin
+ * LOW) can be registered for only `COWPI_FALLING_EDGE`. Changes in the other
+ * direction are discarded before any function is invoked, so they take less
+ * time to service than if the registered function had to discard them.
+ *
+ * @sa cowpi_register_pin_ISR
  *
  * @param interrupt_mask A bit vector specifying which pins will be serviced by
  *      the registered ISR
+ * @param edges The direction(s) of the changes that the registered ISR will
+ *      service
  * @param isr The function that will service interrupts triggered by changes on
  *      the specified pins
  */
-void cowpi_register_pin_ISR(uint32_t interrupt_mask, void (*isr)(void));
+void cowpi_register_pin_edge_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges, void (*isr)(void));
+
+/**
+ * @brief Registers a function, with a context, to service pin-based interrupts
+ * triggered by rising edges, falling edges, or both on one or more pins.
+ *
+ * This function is the same as `cowpi_register_pin_edge_ISR()`, except that the
+ * registered function is told which pin changed and in which direction, and is
+ * given the `context` pointer that was registered with it. A function that
+ * services several pins, such as the keypad's columns, can act on the pin that
+ * changed instead of reading every pin to find it, and a single function can
+ * service several devices of the same kind by registering each device's data as
+ * the context for its pins.
+ * @code
+ * void handle_column(uint8_t pin, cowpi_pin_edge_t edge, void *context) {
+ *     struct keypad *keypad = (struct keypad *) context;
+ *     ...
+ * }
+ *
+ * cowpi_register_pin_context_ISR(column_pins, COWPI_FALLING_EDGE, handle_column, &keypad);
+ * @endcode
+ *
+ * On the ATmega328P, the edge reported for D2 or D3 when registered for both
+ * edges is determined by reading the pin when the function is invoked; for
+ * other pins, the edge is the one that the dispatcher detected.
+ *
+ * @sa cowpi_register_pin_edge_ISR
+ *
+ * @param interrupt_mask A bit vector specifying which pins will be serviced by
+ *      the registered ISR
+ * @param edges The direction(s) of the changes that the registered ISR will
+ *      service
+ * @param isr The function that will service interrupts triggered by changes on
+ *      the specified pins; its arguments are the pin that changed, the
+ *      direction of the change (`COWPI_RISING_EDGE` or `COWPI_FALLING_EDGE`),
+ *      and `context`
+ * @param context A pointer that will be passed to the registered ISR
+ */
+void cowpi_register_pin_context_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges,
+                                    void (*isr)(uint8_t pin, cowpi_pin_edge_t edge, void *context), void *context);
 
 /**
  * @brief De-registers the servicing function, if any, for the specified pin(s).
@@ -87,10 +170,494 @@ void cowpi_register_pin_ISR(uint32_t interrupt_mask, void (*isr)(void));
  * @param interrupt_mask A bit vector specifying which pins will no longer be
  *      serviced by an ISR
  */
-void cowpi_deregister_pin_ISR(uint32_t interrupt_mask);
+void cowpi_deregister_pin_ISR(cowpi_pin_set_t interrupt_mask);
+
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+
+/**
+ * @brief Locks out the specified pin(s) for a time after each invocation of
+ * their interrupt service routines.
+ *
+ * When a pin's registered function is invoked, the pin's interrupt is masked
+ * (its PCMSKx bit, or its EIMSK bit for D2 and D3) until the lockout ends, so
+ * that a bouncing contact or a floating input cannot fire it again. This limits
+ * each pin to one invocation per lockout, no matter how often the pin changes,
+ * so that an interrupt storm cannot starve `loop()`. It also debounces the pin:
+ * the function responds immediately to the first change, and if the pin's
+ * value when the lockout ends is different from the value that the function
+ * was invoked for, then that change is dispatched as soon as the lockout ends.
+ *
+ * The lockouts are timed by TIMER0's comparison B interrupt, which fires once
+ * per millisecond (precisely, every 1.024ms) only while a pin is locked out or
+ * a coalescing window is being timed. Its vector is weak; a program that
+ * defines its own `TIMER0_COMPB_vect` cannot use lockouts.
+ * A lockout lasts at least `lockout_ms` milliseconds and less than one
+ * millisecond longer.
+ *
+ * While a pin is locked out, it is sampled once per millisecond; a sampled
+ * change in a direction that the pin's function is registered for is counted
+ * as a dropped event (see `cowpi_get_dropped_pin_events()`).
+ *
+ * The lockouts apply to the functions registered with
+ * `cowpi_register_pin_ISR()` and the other registration functions, not to
+ * functions bound by `COWPI_BIND_PIN_ISRS()`.
+ *
+ * @param interrupt_mask A bit vector specifying the pins whose lockout is being
+ *      set
+ * @param lockout_ms The length of the lockout in milliseconds, or 0 to stop
+ *      locking out the pins
+ */
+void cowpi_set_pin_ISR_lockout(cowpi_pin_set_t interrupt_mask, uint8_t lockout_ms);
+
+/**
+ * @brief Reports the number of changes on a pin that were dropped because the
+ * pin was locked out.
+ *
+ * The count is a lower bound, because changes that occur between samples cannot
+ * be seen, and it stops at 65535.
+ *
+ * @sa cowpi_set_pin_ISR_lockout
+ *
+ * @param pin The pin whose dropped changes are reported
+ * @return the number of dropped changes since the count was last reset
+ */
+uint16_t cowpi_get_dropped_pin_events(uint8_t pin);
+
+/**
+ * @brief Resets the counts of dropped changes for the specified pin(s) to 0.
+ *
+ * @param interrupt_mask A bit vector specifying the pins whose counts are reset
+ */
+void cowpi_reset_dropped_pin_events(cowpi_pin_set_t interrupt_mask);
+
+/**
+ * @brief The changes on a set of pins during a coalescing window.
+ *
+ * @sa cowpi_register_pin_coalesced_ISR
+ */
+typedef struct {
+    cowpi_pin_set_t changed_pins;       //!< The pins that had at least one edge that the function is registered for
+    cowpi_pin_set_t inputs;             //!< The pins' values when the window ended
+    uint16_t edge_counts[20];           //!< Indexed by pin, the number of edges that the function is registered for (stops at 65535)
+} cowpi_coalesced_pin_events_t;
+
+/**
+ * @brief Registers a function to service the aggregated changes on one or more
+ * pins, once per window, instead of once per change.
+ *
+ * For inputs that change thousands of times per second, invoking a function for
+ * each change would consume most of the processor. Instead, the interrupt only
+ * counts the edges that the function is registered for and notes which pins
+ * had them, which takes a few microseconds per edge, and the function is
+ * invoked once per window with the counts. The processor time spent by the
+ * function is bounded by the window, no matter how quickly the pins change.
+ * @code
+ * void count_pulses(cowpi_coalesced_pin_events_t const *events, void *context) {
+ *     uint16_t *pulses_per_second = (uint16_t *) context;
+ *     *pulses_per_second = events->edge_counts[4] * 10;
+ * }
+ *
+ * if (!cowpi_register_pin_coalesced_ISR(COWPI_PIN_SET(4), COWPI_RISING_EDGE, 100, count_pulses, &rate)) {
+ *     ...
+ * }
+ * @endcode
+ *
+ * If `window_ms` is not 0, then the function is invoked from TIMER0's
+ * comparison B interrupt every `window_ms` milliseconds (measured in 1.024ms
+ * periods, rounded to the nearest period), even if no pins changed. Because it
+ * is invoked from an interrupt, the function should be brief. If `window_ms` is
+ * 0, then the function is invoked by `cowpi_service_coalesced_pin_ISRs()`,
+ * which should be called from `loop()`; the window is the time between calls,
+ * and the function runs with interrupts enabled. A program that defines its own
+ * `TIMER0_COMPB_vect` must use a `window_ms` of 0.
+ *
+ * The registered function replaces any function previously registered for the
+ * specified pins, and registering another function for any of the pins removes
+ * it from the coalesced pins. Lockouts (see `cowpi_set_pin_ISR_lockout()`) do
+ * not apply to coalesced pins. Up to 4 functions can be registered to service
+ * coalesced pins at the same time.
+ *
+ * @param interrupt_mask A bit vector specifying which pins will be serviced by
+ *      the registered ISR
+ * @param edges The direction(s) of the changes that will be counted
+ * @param window_ms The number of milliseconds between invocations of the
+ *      registered ISR, or 0 for the ISR to be invoked by
+ *      `cowpi_service_coalesced_pin_ISRs()`
+ * @param isr The function that will service the changes on the specified pins;
+ *      its arguments are the aggregated changes during the window and `context`
+ * @param context A pointer that will be passed to the registered ISR
+ * @return `true` if the function was registered, `false` if 4 other functions
+ *      are already registered to service coalesced pins
+ */
+__attribute__ ((warn_unused_result))
+bool cowpi_register_pin_coalesced_ISR(cowpi_pin_set_t interrupt_mask, cowpi_pin_edge_t edges, uint16_t window_ms,
+                                      void (*isr)(cowpi_coalesced_pin_events_t const *events, void *context),
+                                      void *context);
+
+/**
+ * @brief Invokes each function registered to service coalesced pins from
+ * `loop()`, with the changes since the previous call.
+ *
+ * Functions registered with a `window_ms` of 0 are invoked; the others are
+ * invoked by TIMER0's comparison B interrupt.
+ *
+ * @sa cowpi_register_pin_coalesced_ISR
+ */
+void cowpi_service_coalesced_pin_ISRs(void);
+
+#define COWPI_MAX_ENCODERS 4            //!< The number of quadrature encoders that can be registered at the same time
+
+/**
+ * @brief Registers a quadrature encoder (such as a rotary encoder) whose A and
+ * B outputs are connected to the specified pins.
+ *
+ * The encoder is decoded directly in the pins' interrupt vectors, without
+ * invoking a registered function: each change on either pin is looked up in a
+ * 16-entry table of the previous and current A/B values, which increments or
+ * decrements the encoder's 32-bit position by 1. Every transition is counted,
+ * so a full cycle of the A/B outputs (often one detent on a rotary encoder)
+ * changes the position by 4. The position increases when A leads B.
+ *
+ * If both pins change between interrupts, then the direction cannot be
+ * determined; the position is unchanged, and the transition is counted as
+ * illegal (see `cowpi_get_encoder_illegal_transitions()`). Illegal transitions
+ * indicate that the encoder is stepping faster than it can be decoded, or that
+ * its contacts are bouncing.
+ *
+ * The maximum step rate is limited by the time that the pin change interrupt's
+ * vector takes to decode a transition. These times are estimated from the
+ * instruction sequences, not measured, for an encoder whose pins are the only
+ * ones changing in their I/O bank. The maximum step rate is half of the rate
+ * at which the vector could run back-to-back, which leaves a margin for A and
+ * B edges that are not evenly spaced and for the Arduino core's TIMER0
+ * overflow interrupt.
+ * | Board             | Microcontroller | Clock   | Vector time (estimated) | Maximum step rate (estimated)   |
+ * |:-----------------:|:---------------:|:-------:|:-----------------------:|:--------------------------------|
+ * | Arduino Uno       | ATmega328P      | 16 MHz  | about 10us              | about 50,000 transitions/second |
+ * | Arduino Nano      | ATmega328P      | 16 MHz  | about 10us              | about 50,000 transitions/second |
+ * | Arduino Mega 2560 | ATmega2560      | 16 MHz  | --                      | no encoder engine               |
+ * | Raspberry Pi Pico | RP2040          | 125 MHz | --                      | no encoder engine               |
+ *
+ * Each other encoder with a pin in the same I/O bank adds about 3us, as does a
+ * registered function that is invoked. Another interrupt that is being
+ * serviced delays the decoding until it finishes. Pins D2 and D3 are serviced
+ * by the external interrupts INT0 and INT1, which have slightly lower latency.
+ * The encoder engine is available only on the Arduino Uno and Arduino Nano;
+ * on the Arduino Mega 2560 and the Raspberry Pi Pico, the encoder functions
+ * are not declared. Encoders are not decoded by the vectors that
+ * `COWPI_BIND_PIN_ISRS()` defines.
+ *
+ * Any function previously registered for the pins is deregistered, and any
+ * other encoder using either pin is deregistered. Registering a function for
+ * either pin afterward deregisters the encoder.
+ *
+ * @param encoder The encoder's number, from 0 to `COWPI_MAX_ENCODERS`-1
+ * @param a_pin The pin connected to the encoder's A output
+ * @param b_pin The pin connected to the encoder's B output
+ * @return `true` if the encoder was registered, `false` if the encoder number
+ *      or a pin is out of range, or if the pins are the same pin
+ */
+__attribute__ ((warn_unused_result))
+bool cowpi_register_encoder(uint8_t encoder, uint8_t a_pin, uint8_t b_pin);
+
+/**
+ * @brief De-registers a quadrature encoder, disabling its pins' interrupts.
+ *
+ * @param encoder The encoder's number
+ */
+void cowpi_deregister_encoder(uint8_t encoder);
+
+/**
+ * @brief Reports a quadrature encoder's position.
+ *
+ * A 32-bit value cannot be read in a single instruction on an 8-bit
+ * microcontroller, so the position is read with interrupts disabled; it will
+ * never be a mix of the values before and after a transition.
+ *
+ * @param encoder The encoder's number
+ * @return the number of transitions in the positive direction, less the number
+ *      in the negative direction, since the encoder was registered or its
+ *      position was set
+ */
+int32_t cowpi_get_encoder_position(uint8_t encoder);
+
+/**
+ * @brief Sets a quadrature encoder's position, such as to 0 to make its
+ * current position the origin.
+ *
+ * @param encoder The encoder's number
+ * @param position The encoder's new position
+ */
+void cowpi_set_encoder_position(uint8_t encoder, int32_t position);
+
+/**
+ * @brief Reports the number of transitions of a quadrature encoder that could
+ * not be decoded because both pins changed between interrupts.
+ *
+ * The count stops at 65535.
+ *
+ * @sa cowpi_register_encoder
+ *
+ * @param encoder The encoder's number
+ * @return the number of illegal transitions since the encoder was registered
+ *      or the count was last reset
+ */
+uint16_t cowpi_get_encoder_illegal_transitions(uint8_t encoder);
+
+/**
+ * @brief Resets the count of a quadrature encoder's illegal transitions to 0.
+ *
+ * @param encoder The encoder's number
+ */
+void cowpi_reset_encoder_illegal_transitions(uint8_t encoder);
+
+#endif //ARDUINO_AVR_UNO || ARDUINO_AVR_NANO
 
 #ifdef __cplusplus
 } // extern "C"
 #endif
 
+#if defined (__cplusplus) && (defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO))
+
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "../boards/registers.h"
+
+namespace cowpi {
+
+/**
+ * @brief Binds a function, at compile time, to service pin-based interrupts
+ * triggered by changes on a pin.
+ *
+ * Used only as an argument to `COWPI_BIND_PIN_ISRS()`.
+ *
+ * @tparam PIN the pin whose changes will be serviced
+ * @tparam HANDLER the function that will service the pin's changes
+ * @tparam EDGES the direction(s) of the changes that `HANDLER` will service
+ */
+template <uint8_t PIN, void (*HANDLER)(void), cowpi_pin_edge_t EDGES = COWPI_BOTH_EDGES>
+struct PinISR {
+    static_assert(PIN < 20, "The ATmega328P has only pins 0-19");
+
+    static constexpr uint8_t pin = PIN;                 //!< The pin whose changes will be serviced
+    static constexpr cowpi_pin_edge_t edges = EDGES;    //!< The direction(s) of the changes that will be serviced
+
+    /** @brief Services a change on the pin. */
+    static inline __attribute__ ((always_inline)) void handle() { HANDLER(); }
+};
+
+/** @cond INTERNAL */
+template <typename... BINDINGS>
+struct PinISRList;
+
+template <>
+struct PinISRList<> {
+    static constexpr cowpi_pin_set_t pins(uint8_t) { return 0; }
+
+    template <uint8_t FIRST_PIN, uint8_t LAST_PIN>
+    static inline __attribute__ ((always_inline)) void dispatch(uint8_t) {}
+};
+
+template <typename BINDING, typename... BINDINGS>
+struct PinISRList<BINDING, BINDINGS...> {
+    // the pins that are bound for any of the specified edges
+    static constexpr cowpi_pin_set_t pins(uint8_t edges) {
+        return ((BINDING::edges & edges) ? COWPI_PIN_SET(BINDING::pin) : 0) | PinISRList<BINDINGS...>::pins(edges);
+    }
+
+    // the bound pins are tested in the order that they were listed, and every test is resolved at compile time except
+    // for the pending bit's
+    template <uint8_t FIRST_PIN, uint8_t LAST_PIN>
+    static inline __attribute__ ((always_inline)) void dispatch(uint8_t pending) {
+        if ((FIRST_PIN <= BINDING::pin) && (BINDING::pin <= LAST_PIN)
+            && (pending & (1 << ((BINDING::pin - FIRST_PIN) & 0x7)))) {
+            BINDING::handle();
+        }
+        PinISRList<BINDINGS...>::template dispatch<FIRST_PIN, LAST_PIN>(pending);
+    }
+};
+/** @endcond */
+
+/**
+ * @brief The pin-based interrupt handlers bound by `COWPI_BIND_PIN_ISRS()`.
+ *
+ * @tparam BINDINGS the `cowpi::PinISR` bindings
+ */
+template <typename... BINDINGS>
+class StaticPinISRs {
+    typedef PinISRList<BINDINGS...> bindings;
+    static_assert(__builtin_popcountl(bindings::pins(COWPI_BOTH_EDGES)) == sizeof...(BINDINGS),
+                  "Each pin can be bound to only one handler");
+
+    // indexed by the I/O bank (COWPI_PB, etc), the most recent values of the bound pins
+    static uint8_t volatile inputs[3];
+
+    static constexpr uint8_t pins_in_bank(cowpi_pin_set_t pins, uint8_t first_pin, uint8_t last_pin) {
+        return (uint8_t) ((pins >> first_pin) & ((1 << (last_pin - first_pin + 1)) - 1));
+    }
+
+    // D2 and D3 use INT0 and INT1 (see cowpi_register_pin_ISR())
+    static constexpr cowpi_pin_set_t pin_change_pins(uint8_t edges) {
+        return bindings::pins(edges) & ~(COWPI_PIN_SET(2) | COWPI_PIN_SET(3));
+    }
+
+    // ISCx1:ISCx0 -- 01 = any change, 10 = falling edge, 11 = rising edge
+    static constexpr uint8_t external_interrupt_sense(uint8_t pin) {
+        return !(bindings::pins(COWPI_BOTH_EDGES) & COWPI_PIN_SET(pin)) ? 0x0
+               : !(bindings::pins(COWPI_RISING_EDGE) & COWPI_PIN_SET(pin)) ? 0x2
+               : !(bindings::pins(COWPI_FALLING_EDGE) & COWPI_PIN_SET(pin)) ? 0x3
+               : 0x1;
+    }
+
+    template <uint8_t IO_BANK, uint8_t FIRST_PIN, uint8_t LAST_PIN>
+    static inline __attribute__ ((always_inline)) void enable_bank(void) {
+        cowpi_ioport_t volatile *ioports = registers::ioports::get();
+        cowpi_pininterrupt_t volatile *pin_interrupts = registers::pin_interrupts::get();
+        constexpr uint8_t pins = pins_in_bank(pin_change_pins(COWPI_BOTH_EDGES), FIRST_PIN, LAST_PIN);
+        if (pins) {
+            pin_interrupts->pci_mask[IO_BANK] |= pins;
+            inputs[IO_BANK] = ioports[IO_BANK].input & pins;
+            pin_interrupts->pci_control |= 1 << IO_BANK;    // PCIEx bit positions match the I/O bank indices
+        }
+    }
+
+public:
+    /**
+     * @brief Enables the interrupts for the bound pins.
+     *
+     * Pins that are not bound are unaffected.
+     */
+    static void enable(void) {
+        cowpi_pininterrupt_t volatile *pin_interrupts = registers::pin_interrupts::get();
+        constexpr uint8_t external_interrupts = pins_in_bank(bindings::pins(COWPI_BOTH_EDGES), 2, 3);
+        constexpr uint8_t sense = external_interrupt_sense(2) | (external_interrupt_sense(3) << 2);
+        constexpr uint8_t sense_mask = ((external_interrupts & 0x1) ? 0x3 : 0) | ((external_interrupts & 0x2) ? 0xC : 0);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (external_interrupts) {
+                // changing the sense can set the interrupt flag, so the datasheet's order must be followed
+                pin_interrupts->ei_mask &= ~external_interrupts;
+                pin_interrupts->ei_control = (pin_interrupts->ei_control & ~sense_mask) | sense;
+                pin_interrupts->ei_flags = external_interrupts;
+                pin_interrupts->ei_mask |= external_interrupts;
+            }
+            enable_bank<COWPI_PD, 0, 7>();
+            enable_bank<COWPI_PB, 8, 13>();
+            enable_bank<COWPI_PC, 14, 19>();
+        }
+    }
+
+    /**
+     * @brief Disables the interrupts for the bound pins.
+     *
+     * Pins that are not bound are unaffected.
+     */
+    static void disable(void) {
+        cowpi_pininterrupt_t volatile *pin_interrupts = registers::pin_interrupts::get();
+        constexpr cowpi_pin_set_t pins = pin_change_pins(COWPI_BOTH_EDGES);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            pin_interrupts->ei_mask &= ~pins_in_bank(bindings::pins(COWPI_BOTH_EDGES), 2, 3);
+            pin_interrupts->pci_mask[COWPI_PD] &= ~pins_in_bank(pins, 0, 7);
+            pin_interrupts->pci_mask[COWPI_PB] &= ~pins_in_bank(pins, 8, 13);
+            pin_interrupts->pci_mask[COWPI_PC] &= ~pins_in_bank(pins, 14, 19);
+        }
+    }
+
+    /** @cond INTERNAL */
+    template <uint8_t PIN>
+    static inline __attribute__ ((always_inline)) void service_external_interrupt(void) {
+        bindings::template dispatch<PIN, PIN>(0x1);
+    }
+
+    template <uint8_t IO_BANK, uint8_t FIRST_PIN, uint8_t LAST_PIN>
+    static inline __attribute__ ((always_inline)) void service_pin_change_interrupt(void) {
+        constexpr uint8_t rising_edge_pins = pins_in_bank(pin_change_pins(COWPI_RISING_EDGE), FIRST_PIN, LAST_PIN);
+        constexpr uint8_t falling_edge_pins = pins_in_bank(pin_change_pins(COWPI_FALLING_EDGE), FIRST_PIN, LAST_PIN);
+        if (!(rising_edge_pins | falling_edge_pins)) {
+            return;
+        }
+        uint8_t new_inputs = registers::ioports::get()[IO_BANK].input & (rising_edge_pins | falling_edge_pins);
+        uint8_t changes = new_inputs ^ inputs[IO_BANK];
+        inputs[IO_BANK] = new_inputs;
+        uint8_t pending = (changes & new_inputs & rising_edge_pins) | (changes & ~new_inputs & falling_edge_pins);
+        bindings::template dispatch<FIRST_PIN, LAST_PIN>(pending);
+    }
+    /** @endcond */
+};
+
+/** @cond INTERNAL */
+template <typename... BINDINGS>
+uint8_t volatile StaticPinISRs<BINDINGS...>::inputs[3];
+/** @endcond */
+
+} // namespace cowpi
+
+/**
+ * @brief Binds functions to service pin-based interrupts at compile time.
+ *
+ * This is an alternative to `cowpi_register_pin_ISR()` and the other
+ * registration functions for handlers that are known when the program is
+ * compiled. The interrupt vectors are defined in the file that uses
+ * this macro, and they invoke the bound functions directly instead of through
+ * a table of function pointers; the compiler can inline the functions into the
+ * vectors, and the CowPi library's table (80 bytes of SRAM on the ATmega328P)
+ * is not linked into the program if the registration functions,
+ * `cowpi_set_pin_ISR_lockout()`, and `cowpi_register_pin_coalesced_ISR()` are
+ * never called.
+ *
+ * The costs on a 16 MHz ATmega328P are below. The latencies are estimated from
+ * the instruction sequences, not measured. Each one runs from the interrupt
+ * request to the handler's first instruction, for a single pending pin with no
+ * encoder, lockout, or coalescing.
+ * | Dispatch                           | Pin change latency (estimated) | D2/D3 latency (estimated) | SRAM            |
+ * |:-----------------------------------|:-------------------------------|:--------------------------|:----------------|
+ * | Table (`cowpi_register_pin_ISR()`) | about 100 cycles (6us)         | about 60 cycles (4us)     | about 340 bytes |
+ * | Bound, handler called              | about 55 cycles (3.5us)        | about 45 cycles (3us)     | 3 bytes         |
+ * | Bound, handler inlined             | about 30 cycles (2us)          | about 20 cycles (1.3us)   | 3 bytes         |
+ *
+ * Most of the difference is in the vector's prologue. A vector that calls a
+ * function must first save every call-clobbered register, which takes about 30
+ * cycles. A vector whose handler is inlined saves only the registers that the
+ * handler uses. The table's SRAM includes the 80-byte table itself; each entry
+ * has held a context pointer beside its function pointer since
+ * `cowpi_register_pin_context_ISR()` was added, which doubled the table from
+ * 40 bytes. The rest is about 260 bytes of state for edges, lockouts,
+ * coalesced edges, and encoders, which the library's vectors reference. The
+ * bound handlers' only SRAM is the previous value of each I/O bank's bound
+ * pins.
+ *
+ * The macro must be used at file scope, only once per program. The first
+ * argument names the type whose `enable()` function will enable the bound
+ * pins' interrupts; each other argument is a `cowpi::PinISR` binding. When a
+ * single interrupt reports changes on more than one bound pin, their functions
+ * are invoked in the order that the bindings are listed.
+ * @code
+ * COWPI_BIND_PIN_ISRS(button_isrs,
+ *                     cowpi::PinISR<LEFT_BUTTON, handle_left_button, COWPI_FALLING_EDGE>,
+ *                     cowpi::PinISR<RIGHT_BUTTON, handle_right_button>);
+ *
+ * void setup() {
+ *     ...
+ *     button_isrs::enable();
+ * }
+ * @endcode
+ *
+ * Because the program's vectors replace the library's, functions registered
+ * with `cowpi_register_pin_ISR()` or the other registration functions
+ * (including the keypad's, for `cowpi_enable_keypad_interrupts()`) will not be
+ * invoked.
+ *
+ * @param name the name of the type whose `enable()` and `disable()` functions
+ *      enable and disable the bound pins' interrupts
+ * @param ... the `cowpi::PinISR` bindings
+ */
+#define COWPI_BIND_PIN_ISRS(name, ...)                                                                      \
+    typedef cowpi::StaticPinISRs<__VA_ARGS__> name;                                                         \
+    ISR(INT0_vect) { name::service_external_interrupt<2>(); }                                               \
+    ISR(INT1_vect) { name::service_external_interrupt<3>(); }                                               \
+    ISR(PCINT0_vect) { name::service_pin_change_interrupt<COWPI_PB, 8, 13>(); }                             \
+    ISR(PCINT1_vect) { name::service_pin_change_interrupt<COWPI_PC, 14, 19>(); }                            \
+    ISR(PCINT2_vect) { name::service_pin_change_interrupt<COWPI_PD, 0, 7>(); }
+
+#endif //__cplusplus && (ARDUINO_AVR_UNO || ARDUINO_AVR_NANO)
+
 #endif //COWPI_PIN_INTERRUPTS_H
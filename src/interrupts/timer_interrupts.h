@@ -33,6 +33,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /**
@@ -106,6 +107,28 @@ float configure_timer(unsigned int timer_number, float desired_period_us);
  */
 bool register_periodic_ISR(unsigned int timer_number, unsigned int isr_slot, void (*isr)(void)) __attribute__ ((warn_unused_result));
 
+/**
+ * @brief Registers a function, with a context, to service periodic timer
+ * interrupts.
+ *
+ * This function is the same as `register_periodic_ISR()`, except that the
+ * registered function is given the `context` pointer that was registered with
+ * it, so that a single function can service several timers or ISR slots, each
+ * with its own data.
+ *
+ * @sa register_periodic_ISR
+ *
+ * @param timer_number The timer whose interrupt will invoke the ISR
+ * @param isr_slot 0 if the ISR should be invoked when the counter resets,
+ *      1 or 2 otherwise
+ * @param isr The function that will service the timer's interrupts
+ * @param context A pointer that will be passed to the registered ISR
+ * @return <code>true</code> if the ISR was successfully registered;
+ *      <code>false</code> otherwise
+ */
+bool register_periodic_context_ISR(unsigned int timer_number, unsigned int isr_slot, void (*isr)(void *context),
+                                   void *context) __attribute__ ((warn_unused_result));
+
 /**
  * @brief Enable TIMER0 comparison interrupt to support
  *      <code>get_timer0_overflow_count()</code>
@@ -158,10 +181,191 @@ unsigned long get_timer0_overflow_count(void);
  */
 bool register_periodic_ISR(unsigned int timer_number, uint32_t period_us, void (*isr)(void)) __attribute__ ((warn_unused_result));
 
+/**
+ * @brief Configures a periodic timer interrupt to fire, and assigns a function,
+ * with a context, to service that interrupt.
+ *
+ * This function is the same as `register_periodic_ISR()`, except that the
+ * registered function is given the `context` pointer that was registered with
+ * it, so that a single function can service several timers, each with its own
+ * data.
+ *
+ * @sa register_periodic_ISR
+ *
+ * @param timer_number A unique handle for the virtual periodic timer being configured
+ * @param period_us The specified interrupt period
+ * @param isr The function that will service the timer's interrupts
+ * @param context A pointer that will be passed to the registered ISR
+ * @return <code>true</code> if the periodic interrupt was successfully
+ *      configured and the ISR was successfully registered; <code>false</code>
+ *      otherwise
+ */
+bool register_periodic_context_ISR(unsigned int timer_number, uint32_t period_us, void (*isr)(void *context),
+                                   void *context) __attribute__ ((warn_unused_result));
+
 #endif //__MBED__
 
 #ifdef __cplusplus
 } // extern "C"
 #endif
 
+#if defined (__cplusplus) && defined (__AVR__)
+
+#include <avr/interrupt.h>
+
+namespace cowpi {
+
+/** @cond INTERNAL */
+template <void (*HANDLER)(void)>
+struct TimerISRSlot {
+    static constexpr bool is_bound = true;
+    static inline __attribute__ ((always_inline)) void handle() { HANDLER(); }
+};
+
+template <>
+struct TimerISRSlot<nullptr> {
+    static constexpr bool is_bound = false;
+    static inline __attribute__ ((always_inline)) void handle() {}
+};
+/** @endcond */
+
+/**
+ * @brief The timer interrupt handlers bound by `COWPI_BIND_TIMER_ISRS()`.
+ *
+ * @tparam TIMER_NUMBER the timer whose interrupts will invoke the handlers
+ * @tparam SLOT0 the function for ISR slot 0
+ * @tparam SLOT1 the function, if any, for ISR slot 1
+ * @tparam SLOT2 the function, if any, for ISR slot 2
+ */
+template <unsigned int TIMER_NUMBER, void (*SLOT0)(void), void (*SLOT1)(void) = nullptr, void (*SLOT2)(void) = nullptr>
+class StaticTimerISRs {
+    static_assert(TIMER_NUMBER == 1 || TIMER_NUMBER == 2, "ISRs can be bound only for TIMER1 and TIMER2");
+
+    static constexpr uint8_t bound_slots = (TimerISRSlot<SLOT0>::is_bound ? 0x1 : 0)
+                                           | (TimerISRSlot<SLOT1>::is_bound ? 0x2 : 0)
+                                           | (TimerISRSlot<SLOT2>::is_bound ? 0x4 : 0);
+
+    // configure_timer() selects CTC mode with WGM12 (TIMER1) or WGM21 (TIMER2)
+    static inline __attribute__ ((always_inline)) bool is_in_ctc_mode(void) {
+        return (TIMER_NUMBER == 1) ? (TCCR1B & (1 << 3)) : (TCCR2A & (1 << 1));
+    }
+
+    static inline __attribute__ ((always_inline)) uint8_t volatile &interrupt_mask(void) {
+        return (TIMER_NUMBER == 1) ? TIMSK1 : TIMSK2;
+    }
+
+public:
+    /**
+     * @brief Enables the timer's interrupts for the bound ISR slots.
+     *
+     * The timer must have previously been configured using
+     * <code>configure_timer()</code>.
+     *
+     * @return <code>true</code> if the interrupts were enabled;
+     *      <code>false</code> if a function is bound to slot 2 but the timer is
+     *      in CTC mode
+     */
+    static __attribute__ ((warn_unused_result)) bool enable(void) {
+        if (is_in_ctc_mode()) {
+            if (TimerISRSlot<SLOT2>::is_bound) {
+                return false;
+            }
+            // slots 0 and 1 use TIMERx_COMPA_vect and TIMERx_COMPB_vect
+            interrupt_mask() |= bound_slots << 1;
+        } else {
+            // slots 0, 1, and 2 use TIMERx_OVF_vect, TIMERx_COMPA_vect, and TIMERx_COMPB_vect
+            interrupt_mask() |= bound_slots;
+        }
+        return true;
+    }
+
+    /** @brief Disables the timer's interrupts. */
+    static void disable(void) {
+        interrupt_mask() &= ~0x7;
+    }
+
+    /** @cond INTERNAL */
+    static inline __attribute__ ((always_inline)) void service_overflow(void) {
+        TimerISRSlot<SLOT0>::handle();
+    }
+
+    static inline __attribute__ ((always_inline)) void service_compareA(void) {
+        if (is_in_ctc_mode()) {
+            TimerISRSlot<SLOT0>::handle();
+        } else {
+            TimerISRSlot<SLOT1>::handle();
+        }
+    }
+
+    static inline __attribute__ ((always_inline)) void service_compareB(void) {
+        if (is_in_ctc_mode()) {
+            TimerISRSlot<SLOT1>::handle();
+        } else {
+            TimerISRSlot<SLOT2>::handle();
+        }
+    }
+    /** @endcond */
+};
+
+} // namespace cowpi
+
+/**
+ * @brief Binds functions to service periodic timer interrupts at compile time.
+ *
+ * This is an alternative to `register_periodic_ISR()` for handlers that are
+ * known when the program is compiled. The timer's interrupt vectors are defined
+ * in the file that uses this macro, and they invoke the bound functions
+ * directly instead of through a table of function pointers; the compiler can
+ * inline the functions into the vectors, and the CowPi library's table is not
+ * linked into the program if `register_periodic_ISR()` is never called. The
+ * ISR slots are the same as for `register_periodic_ISR()`.
+ *
+ * The costs on a 16 MHz ATmega328P are below. The latencies are estimated from
+ * the instruction sequences, not measured, and run from the interrupt request
+ * to the handler's first instruction.
+ * | Dispatch                          | Latency (estimated)     | SRAM     |
+ * |:----------------------------------|:------------------------|:---------|
+ * | Table (`register_periodic_ISR()`) | about 50 cycles (3us)   | 39 bytes |
+ * | Bound, handler called             | about 45 cycles (3us)   | none     |
+ * | Bound, handler inlined            | about 20 cycles (1.3us) | none     |
+ *
+ * A vector that calls a function, directly or through the table, must first
+ * save every call-clobbered register, which takes about 30 cycles. Binding
+ * therefore saves little time unless the compiler inlines the handler. The
+ * table's SRAM is 36 bytes for the nine ISR slots, plus 3 bytes that record
+ * which slots take a context. The slots were 18 bytes before
+ * `register_periodic_context_ISR()` added a context pointer to each one.
+ *
+ * The macro must be used at file scope, only once per timer. The first argument
+ * names the type whose `enable()` function will enable the timer's interrupts
+ * after the timer is configured; the timer number must be the literal `1` or
+ * `2`.
+ * @code
+ * COWPI_BIND_TIMER_ISRS(sampling_isrs, 1, sample_inputs, update_display);
+ *
+ * void setup() {
+ *     ...
+ *     configure_timer(1, 1000);
+ *     if (!sampling_isrs::enable()) {
+ *         ...
+ *     }
+ * }
+ * @endcode
+ *
+ * Because the program's vectors replace the library's, functions registered
+ * with `register_periodic_ISR()` for that timer will not be invoked.
+ *
+ * @param name the name of the type whose `enable()` and `disable()` functions
+ *      enable and disable the timer's interrupts
+ * @param timer_number the timer whose interrupts will invoke the functions
+ * @param ... the functions for ISR slot 0, and optionally for slots 1 and 2
+ */
+#define COWPI_BIND_TIMER_ISRS(name, timer_number, ...)                                                      \
+    typedef cowpi::StaticTimerISRs<timer_number, __VA_ARGS__> name;                                         \
+    ISR(TIMER##timer_number##_OVF_vect) { name::service_overflow(); }                                       \
+    ISR(TIMER##timer_number##_COMPA_vect) { name::service_compareA(); }                                     \
+    ISR(TIMER##timer_number##_COMPB_vect) { name::service_compareB(); }
+
+#endif //__cplusplus && __AVR__
+
 #endif //COWPI_TIMER_INTERRUPTS_H
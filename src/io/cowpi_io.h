@@ -38,15 +38,21 @@ extern "C" {
 /**
  * @brief Scans the keypad to determine which, if any, key was pressed.
  *
- * There is no debouncing. This is a portable implementation, not a 
- * memory-mapped implementation. Returns the ASCII representation of the 
- * character depicted on whichever key was pressed (0-9, A-D, *, #).
+ * There is no debouncing. On the ATmega328P, the ATmega2560, and the RP2040,
+ * the keypad is scanned using memory-mapped I/O; on other microcontrollers,
+ * this is a portable implementation. Returns the ASCII representation of the character
+ * depicted on whichever key was pressed (0-9, A-D, *, #).
+ *
+ * If the keypad is being scanned in the background, is interrupt-driven, or is
+ * sampled with the other inputs, then the most recent scan is examined instead
+ * of scanning the keypad (see keypad.h and inputs.h).
  *
  * Assumes a common 4x4 matrix keypad with:
  * - Arduino form factors: the rows in pins D4-D7 and the columns in pins A0-A3
  *   (D14-D17 on Uno/Nano).
  * - Raspberry Pi Pico: the rows in pins GP6-GP9 and the columns in pins 
  *   GP10-GP13.
+ * Other keypads can be described when building the library (see keypad.h).
  * 
  * A pressed key grounds a pulled-high input.
  * 
@@ -60,21 +66,28 @@ char cowpi_get_keypress(void);
 /**
  * @brief Scans the keypad to determine which keys have been pressed.
  *
- * There is no debouncing. This is a portable implementation, not a 
- * memory-mapped implementation.
+ * There is no debouncing. On the ATmega328P, the ATmega2560, and the RP2040,
+ * the keypad is scanned using memory-mapped I/O; on other microcontrollers,
+ * this is a portable implementation.
+ *
+ * If the keypad is being scanned in the background, is interrupt-driven, or is
+ * sampled with the other inputs, then the most recent scan is examined instead
+ * of scanning the keypad (see keypad.h and inputs.h).
  * 
  * Returns a bit vector with a 1 (key pressed) or 0 (key not pressed) in each
  * of 16 bits that correspond to the 16 keys. For keys with hexadecimal digits, 
  * the digit indicates the corresponding bit (bit0 corresponds to the "0" key; 
  * bit1 corresponds to the "1" key; ...; and bit13 corresponds to the "D" key). 
  * Additionally, bit14 corresponds to the "#" key and bit15 corresponds to the 
- * "*" key.
+ * "*" key. A keypad described when building the library must depict only
+ * these characters, each on one key.
  *
  * Assumes a common 4x4 matrix keypad with:
  * - Arduino form factors: the rows in pins D4-D7 and the columns in pins A0-A3
  *   (D14-D17 on Uno/Nano).
  * - Raspberry Pi Pico: the rows in pins GP6-GP9 and the columns in pins 
  *   GP10-GP13.
+ * Other keypads can be described when building the library (see keypad.h).
  * 
  * A pressed key grounds a pulled-high input.
  * 
@@ -91,8 +104,9 @@ uint16_t cowpi_get_keypresses(void);
 /**
  * @brief Reports whether the left button is pressed.
  *
- * There is no debouncing. This is a portable implementation, not a
- * memory-mapped implementation.
+ * There is no debouncing. On the ATmega328P, the ATmega2560, and the RP2040,
+ * the pin is read using memory-mapped I/O (see pins.h); on other
+ * microcontrollers, this is a portable implementation.
  *
  * Assumes the left button is in Arduino pin D8 or Raspberry Pi Pico pin GP2.
  * A pressed button grounds a pulled-high input.
@@ -104,8 +118,9 @@ bool cowpi_left_button_is_pressed(void);
 /**
  * @brief Reports whether the right button is pressed.
  *
- * There is no debouncing. This is a portable implementation, not a
- * memory-mapped implementation.
+ * There is no debouncing. On the ATmega328P, the ATmega2560, and the RP2040,
+ * the pin is read using memory-mapped I/O (see pins.h); on other
+ * microcontrollers, this is a portable implementation.
  *
  * Assumes the right button is in Arduino pin D9 or Raspberry Pi Pico pin GP3.
  * A pressed button grounds a pulled-high input.
@@ -187,7 +202,9 @@ bool cowpi_right_switch_is_in_right_position(void);
 /**
  * @brief Illuminates the right LED, aka the external LED.
  *
- * This is a portable implementation, not a memory-mapped implementation.
+ * On the ATmega328P, the ATmega2560, and the RP2040, the pin is written using
+ * memory-mapped I/O (see pins.h); on other microcontrollers, this is a
+ * portable implementation.
  *
  * Assumes the right LED is in Arduino pin D12 or Raspberry Pi Pico pin GP20.
  * An LED illuminates when the pin is placed high, to match the semantics of
@@ -198,7 +215,9 @@ void cowpi_illuminate_right_led(void);
 /**
  * @brief Illuminates the left LED, aka the built-in LED, aka the internal LED.
  *
- * This is a portable implementation, not a memory-mapped implementation.
+ * On the ATmega328P, the ATmega2560, and the RP2040, the pin is written using
+ * memory-mapped I/O (see pins.h); on other microcontrollers, this is a
+ * portable implementation.
  *
  * Assumes the left LED is in Arduino pin D13 or Raspberry Pi Pico pin GP21.
  * An LED illuminates when the pin is placed high, to match the semantics of
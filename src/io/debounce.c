@@ -1,6 +1,6 @@
 /**************************************************************************//**
  *
- * @file cowpi_io.c
+ * @file debounce.c
  *
  * @brief @copybrief debounce.h
  *
@@ -32,21 +32,10 @@ uint8_t cowpi_debounce_byte(uint8_t current_value, enum input_names input_name)
     static uint8_t last_actual_value[NUMBER_OF_INPUTS] = {0};
     static uint8_t last_good_value[NUMBER_OF_INPUTS] = {0};
     static unsigned long last_change[NUMBER_OF_INPUTS] = {[0 ... (NUMBER_OF_INPUTS - 1)] = 0x80000000}; // gcc extension
+    static unsigned long last_call[NUMBER_OF_INPUTS] = {[0 ... (NUMBER_OF_INPUTS - 1)] = 0x80000000}; // gcc extension
     unsigned long now = millis();
-    /*
-    // responds immediately and then ignores further changes until input stabilizes -- more responsive
-    last_good_value[input_name] = (now - last_change[input_name] < DEBOUNCE_THRESHOLD) ? last_good_value[input_name]
-                                                                                       : current_value;
-    last_change[input_name] = (current_value == last_actual_value[input_name]) ? last_change[input_name] : now;
-    */ /* ...OR... */ /*
-    // ignores changes until input stabilizes and then responds -- more immune to transients -- but requires continuous polling
-    last_change[input_name] = (current_value == last_actual_value[input_name]) ? last_change[input_name] : now;
-    last_good_value[input_name] = (now - last_change[input_name] < DEBOUNCE_THRESHOLD) ? last_good_value[input_name]
-                                                                                       : current_value;
-    last_actual_value[input_name] = current_value;
-    */ /* ...OR... */
     // ignores changes until stabilization, but honors Nyquist rate (if we don't sample at least every 10ms then we don't know whether the input has been stable for 20ms)
-    static unsigned long last_call[NUMBER_OF_INPUTS] = {[0 ... (NUMBER_OF_INPUTS - 1)] = 0x80000000}; // gcc extension
+    // (cowpi_debounce_with_lockout() and cowpi_debounce_when_stable() provide the other strategies)
     last_change[input_name] = (current_value == last_actual_value[input_name]) ? last_change[input_name] : now;
     last_good_value[input_name] = (now - last_call[input_name] < DEBOUNCE_THRESHOLD / 2) &&
                                   (now - last_change[input_name] < DEBOUNCE_THRESHOLD)
@@ -54,7 +43,6 @@ uint8_t cowpi_debounce_byte(uint8_t current_value, enum input_names input_name)
                                   : current_value;
     last_actual_value[input_name] = current_value;
     last_call[input_name] = now;
-
     return last_good_value[input_name];
 }
 
@@ -91,3 +79,100 @@ uint32_t cowpi_debounce_long(uint32_t current_value, enum input_names input_name
     last_call[input_name] = now;
     return last_good_value[input_name];
 }
+
+
+/*
+ * A counter of 00 means that the raw input agrees with the debounced input, so a zero-initialized debouncer is idle.
+ * Each differing sample advances the counter 00 -> 01 -> 10 -> 11, and the fourth consecutive differing sample toggles
+ * the debounced input as the counter returns to 00. Any agreeing sample resets the counter to 00.
+ */
+uint32_t cowpi_debounce_vertically(cowpi_vertical_debouncer_t *debouncer, uint32_t raw_inputs) {
+    uint32_t state = debouncer->state;
+    uint32_t count0 = debouncer->count0;
+    uint32_t count1 = debouncer->count1;
+    uint32_t differences = raw_inputs ^ state;
+    uint32_t toggles = differences & count0 & count1;
+    count1 = (count1 ^ count0) & differences;
+    count0 = ~count0 & differences;
+    state ^= toggles;
+    debouncer->state = state;
+    debouncer->count0 = count0;
+    debouncer->count1 = count1;
+    debouncer->rising = state & toggles;
+    debouncer->falling = ~state & toggles;
+    return state;
+}
+
+
+void cowpi_initialize_debouncer(cowpi_debouncer_t *debouncer, uint8_t threshold_ms) {
+    *debouncer = (cowpi_debouncer_t) COWPI_DEBOUNCER(threshold_ms);
+}
+
+
+void cowpi_initialize_lockout_debouncer(cowpi_lockout_debouncer_t *debouncer, uint8_t threshold_ms) {
+    *debouncer = (cowpi_lockout_debouncer_t) COWPI_LOCKOUT_DEBOUNCER(threshold_ms);
+}
+
+
+void cowpi_initialize_stable_debouncer(cowpi_stable_debouncer_t *debouncer, uint8_t threshold_ms) {
+    *debouncer = (cowpi_stable_debouncer_t) COWPI_STABLE_DEBOUNCER(threshold_ms);
+}
+
+
+// the parentheses prevent the function's name from being expanded as the strategy-selecting macro
+uint16_t (cowpi_debounce)(cowpi_debouncer_t *debouncer, uint16_t current_value) {
+    // 16-bit differences are correct across the 16-bit wraparound, as long as they are less than 65536ms
+    uint16_t now = (uint16_t) millis();
+    if (!debouncer->initialized) {
+        // the first sample is the stable value, and the last change is a full threshold in the past
+        debouncer->last_actual_value = current_value;
+        debouncer->last_good_value = current_value;
+        debouncer->last_change = (uint16_t) (now - debouncer->threshold);
+        debouncer->last_call = now;
+        debouncer->initialized = true;
+    }
+    debouncer->last_change = (current_value == debouncer->last_actual_value) ? debouncer->last_change : now;
+    debouncer->last_good_value = ((uint16_t) (now - debouncer->last_call) < debouncer->threshold / 2) &&
+                                 ((uint16_t) (now - debouncer->last_change) < debouncer->threshold)
+                                 ? debouncer->last_good_value
+                                 : current_value;
+    debouncer->last_actual_value = current_value;
+    debouncer->last_call = now;
+    return debouncer->last_good_value;
+}
+
+
+// responds immediately and then ignores further changes until input stabilizes -- more responsive
+uint16_t cowpi_debounce_with_lockout(cowpi_lockout_debouncer_t *debouncer, uint16_t current_value) {
+    uint16_t now = (uint16_t) millis();
+    if (!debouncer->initialized) {
+        debouncer->last_actual_value = current_value;
+        debouncer->last_good_value = current_value;
+        debouncer->last_change = (uint16_t) (now - debouncer->threshold);
+        debouncer->initialized = true;
+    }
+    debouncer->last_good_value = ((uint16_t) (now - debouncer->last_change) < debouncer->threshold)
+                                 ? debouncer->last_good_value
+                                 : current_value;
+    debouncer->last_change = (current_value == debouncer->last_actual_value) ? debouncer->last_change : now;
+    debouncer->last_actual_value = current_value;
+    return debouncer->last_good_value;
+}
+
+
+// ignores changes until input stabilizes and then responds -- more immune to transients -- but requires continuous polling
+uint16_t cowpi_debounce_when_stable(cowpi_stable_debouncer_t *debouncer, uint16_t current_value) {
+    uint16_t now = (uint16_t) millis();
+    if (!debouncer->initialized) {
+        debouncer->last_actual_value = current_value;
+        debouncer->last_good_value = current_value;
+        debouncer->last_change = (uint16_t) (now - debouncer->threshold);
+        debouncer->initialized = true;
+    }
+    debouncer->last_change = (current_value == debouncer->last_actual_value) ? debouncer->last_change : now;
+    debouncer->last_good_value = ((uint16_t) (now - debouncer->last_change) < debouncer->threshold)
+                                 ? debouncer->last_good_value
+                                 : current_value;
+    debouncer->last_actual_value = current_value;
+    return debouncer->last_good_value;
+}
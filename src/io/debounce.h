@@ -26,6 +26,7 @@
 #ifndef COWPI_DEBOUNCE_H
 #define COWPI_DEBOUNCE_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -156,8 +157,287 @@ uint16_t cowpi_debounce_short(uint16_t current_value, enum input_names input_nam
  */
 uint32_t cowpi_debounce_long(uint32_t current_value, enum input_names input_name);
 
+/**
+ * @brief The state of a debouncer that filters up to 32 inputs in parallel.
+ *
+ * Each bit position is an independent input with its own two-bit counter; the
+ * counters are stored "vertically," with one bit of every counter in `count0`
+ * and the other bit of every counter in `count1`.
+ *
+ * A zero-initialized debouncer is ready to use, with every debounced input
+ * starting at 0.
+ *
+ * @sa cowpi_debounce_vertically
+ */
+typedef struct {
+    uint32_t state;                     //!< The debounced inputs
+    uint32_t count0;                    //!< Low bit of each input's count of consecutive samples that differ from `state`
+    uint32_t count1;                    //!< High bit of each input's count of consecutive samples that differ from `state`
+    uint32_t rising;                    //!< The inputs that changed from 0 to 1 in the most recent sample
+    uint32_t falling;                   //!< The inputs that changed from 1 to 0 in the most recent sample
+} cowpi_vertical_debouncer_t;
+
+/**
+ * @brief Debounces up to 32 inputs at once, using a vertical counter for each
+ * bit.
+ *
+ * The raw inputs are packed into a single word; for example, the 16 bits from
+ * `cowpi_get_keypresses()` and a bit for each button and switch. A debounced
+ * input changes only after its raw value has differed from the debounced value
+ * in four consecutive samples, and any sample that agrees with the debounced
+ * value restarts that input's count. Every input is filtered with the same
+ * handful of bitwise operations, no matter how many inputs there are or which
+ * of them are changing. Each sample costs an estimated 100 cycles on a 16MHz
+ * ATmega328P; the estimate is counted from the instruction sequence, not
+ * measured.
+ *
+ * Unlike `cowpi_debounce_byte()` and its siblings, this function does not read
+ * the time; debouncing depends on the inputs being sampled periodically, such
+ * as from a timer interrupt. Sampling every 5ms requires an input to be stable
+ * for 20ms before its change is reported.
+ *
+ * After each sample, the debouncer's `rising` and `falling` fields indicate
+ * which debounced inputs changed from 0 to 1 and which changed from 1 to 0.
+ *
+ * @sa cowpi_vertical_debouncer_t
+ *
+ * @param debouncer the debouncer's state
+ * @param raw_inputs the inputs' current, un-debounced values
+ * @return the inputs' values after mechanical bouncing has been filtered-out
+ */
+uint32_t cowpi_debounce_vertically(cowpi_vertical_debouncer_t *debouncer, uint32_t raw_inputs);
+
+/**
+ * @brief The state of a single debounced input, with its own threshold.
+ *
+ * Unlike the `input_names` used by `cowpi_debounce_byte()` and its siblings, a
+ * debouncer is declared by the program for each input that it debounces, so
+ * the memory used for debouncing grows only with the number of inputs that are
+ * actually debounced. The debouncer's address is the handle that is passed to
+ * `cowpi_debounce()`.
+ *
+ * Times are stored as the lower 16 bits of `millis()`, so a debouncer occupies
+ * 10 bytes on AVR microcontrollers. A debouncer should be initialized with
+ * `COWPI_DEBOUNCER()` or with `cowpi_initialize_debouncer()`; the debouncer
+ * then takes the input's first sample as its stable value.
+ *
+ * A `cowpi_debouncer_t` waits for the input to be stable, but only if the input
+ * is sampled often enough to know that it has been stable. The
+ * `cowpi_lockout_debouncer_t` and `cowpi_stable_debouncer_t` types select other
+ * strategies.
+ *
+ * @sa cowpi_debounce
+ */
+typedef struct {
+    uint16_t last_actual_value;         //!< The input's value when last sampled
+    uint16_t last_good_value;           //!< The input's most recent debounced value
+    uint16_t last_change;               //!< Lower 16 bits of the time, in milliseconds, that the input last changed
+    uint16_t last_call;                 //!< Lower 16 bits of the time, in milliseconds, that the input was last sampled
+    uint8_t threshold;                  //!< The time, in milliseconds, that the input must be stable
+    bool initialized;                   //!< Whether the debouncer has been seeded with the input's first sample
+} cowpi_debouncer_t;
+
+/**
+ * @brief Initializer for a `cowpi_debouncer_t` whose input must be stable for
+ * `threshold_ms` milliseconds.
+ *
+ * For example, `cowpi_debouncer_t left_button = COWPI_DEBOUNCER(5);`
+ */
+#define COWPI_DEBOUNCER(threshold_ms) {0, 0, 0, 0, (threshold_ms), false}
+
+/**
+ * @brief Prepares a debouncer whose input must be stable for `threshold_ms`
+ * milliseconds.
+ *
+ * The next sample passed to `cowpi_debounce()` is taken as the input's stable
+ * value.
+ *
+ * @param debouncer the debouncer to be initialized
+ * @param threshold_ms the time, in milliseconds (at most 255), that the input
+ *      must be stable before a change is reported
+ */
+void cowpi_initialize_debouncer(cowpi_debouncer_t *debouncer, uint8_t threshold_ms);
+
+/**
+ * @brief Applies a software-based low-pass filter to an input, smoothing-out
+ * mechanical switch bounce, using the debouncer's own threshold.
+ *
+ * When the input is stable, this function will return the input's value. When
+ * the input is bouncing, this function will return a stable value. A change is
+ * reported only after the input has been stable for the debouncer's threshold;
+ * if the input has not been sampled at least twice per threshold, then there
+ * is no way to know that the input has been stable, and the input's current
+ * value is returned.
+ *
+ * This function is suitable for inputs that can be represented in sixteen (or
+ * fewer) bits.
+ *
+ * This strategy adds the threshold to the latency of every change. Its
+ * estimated cost on a 16MHz ATmega328P is 65 cycles, plus the call to
+ * `millis()`.
+ *
+ * When passed a `cowpi_lockout_debouncer_t` or a `cowpi_stable_debouncer_t`,
+ * this function instead calls `cowpi_debounce_with_lockout()` or
+ * `cowpi_debounce_when_stable()`; the strategy is selected at compile time.
+ *
+ * @note Because times are stored in 16 bits, an input that is not sampled for
+ *      more than 65 seconds might not be reported for one additional sample.
+ *
+ * @sa cowpi_debouncer_t
+ * @sa cowpi_debounce_with_lockout
+ * @sa cowpi_debounce_when_stable
+ *
+ * @param debouncer the handle of the input's debouncer
+ * @param current_value an expression that evaluates to the input's current,
+ *      un-debounced value
+ * @return the input's value after mechanical bouncing has been filtered-out
+ */
+uint16_t cowpi_debounce(cowpi_debouncer_t *debouncer, uint16_t current_value);
+
+/**
+ * @brief The state of a single debounced input that responds immediately to a
+ * change and then ignores the input until it stabilizes.
+ *
+ * A lockout debouncer occupies 8 bytes on AVR microcontrollers and should be
+ * initialized with `COWPI_LOCKOUT_DEBOUNCER()` or with
+ * `cowpi_initialize_lockout_debouncer()`; the debouncer then takes the input's
+ * first sample as its stable value.
+ *
+ * @sa cowpi_debounce_with_lockout
+ */
+typedef struct {
+    uint16_t last_actual_value;         //!< The input's value when last sampled
+    uint16_t last_good_value;           //!< The input's most recent debounced value
+    uint16_t last_change;               //!< Lower 16 bits of the time, in milliseconds, that the input last changed
+    uint8_t threshold;                  //!< The time, in milliseconds, that the input must be stable
+    bool initialized;                   //!< Whether the debouncer has been seeded with the input's first sample
+} cowpi_lockout_debouncer_t;
+
+/**
+ * @brief The state of a single debounced input that ignores changes until the
+ * input stabilizes.
+ *
+ * A stability debouncer occupies 8 bytes on AVR microcontrollers and should be
+ * initialized with `COWPI_STABLE_DEBOUNCER()` or with
+ * `cowpi_initialize_stable_debouncer()`; the debouncer then takes the input's
+ * first sample as its stable value.
+ *
+ * @sa cowpi_debounce_when_stable
+ */
+typedef struct {
+    uint16_t last_actual_value;         //!< The input's value when last sampled
+    uint16_t last_good_value;           //!< The input's most recent debounced value
+    uint16_t last_change;               //!< Lower 16 bits of the time, in milliseconds, that the input last changed
+    uint8_t threshold;                  //!< The time, in milliseconds, that the input must be stable
+    bool initialized;                   //!< Whether the debouncer has been seeded with the input's first sample
+} cowpi_stable_debouncer_t;
+
+/**
+ * @brief Initializer for a `cowpi_lockout_debouncer_t` that ignores the input
+ * for `threshold_ms` milliseconds after each change.
+ */
+#define COWPI_LOCKOUT_DEBOUNCER(threshold_ms) {0, 0, 0, (threshold_ms), false}
+
+/**
+ * @brief Initializer for a `cowpi_stable_debouncer_t` whose input must be
+ * stable for `threshold_ms` milliseconds.
+ */
+#define COWPI_STABLE_DEBOUNCER(threshold_ms) {0, 0, 0, (threshold_ms), false}
+
+/**
+ * @brief Prepares a lockout debouncer that ignores the input for
+ * `threshold_ms` milliseconds after each change.
+ *
+ * The next sample passed to `cowpi_debounce_with_lockout()` is taken as the
+ * input's stable value.
+ *
+ * @param debouncer the debouncer to be initialized
+ * @param threshold_ms the time, in milliseconds (at most 255), that the input
+ *      is ignored after a change is reported
+ */
+void cowpi_initialize_lockout_debouncer(cowpi_lockout_debouncer_t *debouncer, uint8_t threshold_ms);
+
+/**
+ * @brief Prepares a stability debouncer whose input must be stable for
+ * `threshold_ms` milliseconds.
+ *
+ * The next sample passed to `cowpi_debounce_when_stable()` is taken as the
+ * input's stable value.
+ *
+ * @param debouncer the debouncer to be initialized
+ * @param threshold_ms the time, in milliseconds (at most 255), that the input
+ *      must be stable before a change is reported
+ */
+void cowpi_initialize_stable_debouncer(cowpi_stable_debouncer_t *debouncer, uint8_t threshold_ms);
+
+/**
+ * @brief Debounces an input by responding immediately to a change and then
+ * ignoring the input until it has been stable for the debouncer's threshold.
+ *
+ * This strategy adds no latency to the first change after the input has been
+ * stable, which suits latency-critical buttons, but a single transient will be
+ * reported as a change. It does not require the input to be sampled
+ * periodically. After the first change, the input's value is reported again
+ * at the first sample after it has been stable for the threshold.
+ *
+ * Its estimated cost on a 16MHz ATmega328P is 50 cycles, plus the call to
+ * `millis()`.
+ *
+ * @sa cowpi_lockout_debouncer_t
+ *
+ * @param debouncer the handle of the input's debouncer
+ * @param current_value an expression that evaluates to the input's current,
+ *      un-debounced value
+ * @return the input's value after mechanical bouncing has been filtered-out
+ */
+uint16_t cowpi_debounce_with_lockout(cowpi_lockout_debouncer_t *debouncer, uint16_t current_value);
+
+/**
+ * @brief Debounces an input by ignoring changes until the input has been
+ * stable for the debouncer's threshold.
+ *
+ * This strategy adds the threshold to the latency of every change, but it is
+ * immune to transients, which suits noisy switches. The input must be sampled
+ * continuously: if the input is not sampled while it bounces, the bounce is not
+ * seen.
+ *
+ * Its estimated cost on a 16MHz ATmega328P is 50 cycles, plus the call to
+ * `millis()`.
+ *
+ * @sa cowpi_stable_debouncer_t
+ *
+ * @param debouncer the handle of the input's debouncer
+ * @param current_value an expression that evaluates to the input's current,
+ *      un-debounced value
+ * @return the input's value after mechanical bouncing has been filtered-out
+ */
+uint16_t cowpi_debounce_when_stable(cowpi_stable_debouncer_t *debouncer, uint16_t current_value);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
 
+/*
+ * cowpi_debounce() selects the strategy from the debouncer's type at compile time, so each strategy's code is linked
+ * only if some debouncer uses it.
+ */
+#ifdef __cplusplus
+
+inline uint16_t cowpi_debounce(cowpi_lockout_debouncer_t *debouncer, uint16_t current_value) {
+    return cowpi_debounce_with_lockout(debouncer, current_value);
+}
+
+inline uint16_t cowpi_debounce(cowpi_stable_debouncer_t *debouncer, uint16_t current_value) {
+    return cowpi_debounce_when_stable(debouncer, current_value);
+}
+
+#else
+
+#define cowpi_debounce(debouncer, current_value) _Generic((debouncer),                                         \
+        cowpi_lockout_debouncer_t *: cowpi_debounce_with_lockout,                                               \
+        cowpi_stable_debouncer_t *: cowpi_debounce_when_stable,                                                 \
+        cowpi_debouncer_t *: cowpi_debounce)((debouncer), (current_value))
+
+#endif //__cplusplus
+
 #endif //COWPI_DEBOUNCE_H
@@ -0,0 +1,282 @@
+/**************************************************************************//**
+ *
+ * @file inputs.c
+ *
+ * @brief @copybrief inputs.h
+ *
+ * @details @copydetails inputs.h
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include "cowpi_io.h"
+#include "debounce.h"
+#include "inputs.h"
+#include "../internal/cowpi_internal.h"
+#include "../boards/boards.h"
+#include "../interrupts/timer_interrupts.h"
+
+#if defined (__AVR__)
+// there is only one core, and the ISR cannot be interrupted by the reader, so only the compiler must be restrained
+#define MEMORY_BARRIER() __asm__ __volatile__ ("" ::: "memory")
+#else
+#define MEMORY_BARRIER() __sync_synchronize()
+#endif //__AVR__
+
+
+/* Reading the inputs */
+
+/*
+ * The keypad's bits are passed in, either from cowpi_get_keypresses() or from the keypad's most recent report. Every
+ * other input is taken from a single read of each I/O port: on a 16MHz ATmega328P, that takes approximately 40 cycles
+ * instead of the approximately 350 cycles for six digitalRead() calls (approximately 600 cycles for ten, without a
+ * display protocol), estimated from the instruction sequences. The ATmega2560 is read the same way, from ports B, F,
+ * and H.
+ */
+
+#if defined (__AVR_ATmega328P__)
+
+#define PIN_IS_HIGH(pin) ((input[COWPI_PIN_PORT(pin)] & COWPI_PIN_MASK(pin)) != 0)
+
+static uint32_t read_inputs(uint32_t inputs) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    uint8_t input[3];
+    input[D8_D13] = ioports[D8_D13].input;
+    input[A0_A5] = ioports[A0_A5].input;
+    input[D0_D7] = ioports[D0_D7].input;
+    // if both possible switch positions are 1, then it's to the right, regardless of which pin is being used
+    bool left_switch_is_right = (cowpi_left_switch != UNASSIGNED_PIN)
+                                ? PIN_IS_HIGH(cowpi_left_switch)
+                                : PIN_IS_HIGH(LEFT_SWITCH_SPI) && PIN_IS_HIGH(LEFT_SWITCH_I2C);
+    bool right_switch_is_right = (cowpi_right_switch != UNASSIGNED_PIN)
+                                 ? PIN_IS_HIGH(cowpi_right_switch)
+                                 : PIN_IS_HIGH(RIGHT_SWITCH_SPI) && PIN_IS_HIGH(RIGHT_SWITCH_I2C);
+    inputs |= PIN_IS_HIGH(LEFT_BUTTON) ? 0 : COWPI_LEFT_BUTTON_INPUT;
+    inputs |= PIN_IS_HIGH(RIGHT_BUTTON) ? 0 : COWPI_RIGHT_BUTTON_INPUT;
+    inputs |= left_switch_is_right ? COWPI_LEFT_SWITCH_INPUT : 0;
+    inputs |= right_switch_is_right ? COWPI_RIGHT_SWITCH_INPUT : 0;
+    return inputs;
+}
+
+#elif defined (__AVR_ATmega2560__)
+
+#define PIN_IS_HIGH(pin) ((input[COWPI_PIN_PORT(pin)] & COWPI_PIN_MASK(pin)) != 0)
+// a switch's pin is one of its two possible pins, so each comparison selects a constant port and bit
+#define SWITCH_IS_RIGHT(pin, spi_pin, i2c_pin) ((pin) == (spi_pin) ? PIN_IS_HIGH(spi_pin)                       \
+                                                : (pin) == (i2c_pin) ? PIN_IS_HIGH(i2c_pin)                     \
+                                                : PIN_IS_HIGH(spi_pin) && PIN_IS_HIGH(i2c_pin))
+
+static uint32_t read_inputs(uint32_t inputs) {
+    uint8_t input[COWPI_NUMBER_OF_PORTS];
+    // the buttons are in port H, and the switches are in port F (SPI) or port B (I2C)
+    input[COWPI_PB] = COWPI_IOPORT(COWPI_PB)->input;
+    input[COWPI_PF] = COWPI_IOPORT(COWPI_PF)->input;
+    input[COWPI_PH] = COWPI_IOPORT(COWPI_PH)->input;
+    // if both possible switch positions are 1, then it's to the right, regardless of which pin is being used
+    bool left_switch_is_right = SWITCH_IS_RIGHT(cowpi_left_switch, LEFT_SWITCH_SPI, LEFT_SWITCH_I2C);
+    bool right_switch_is_right = SWITCH_IS_RIGHT(cowpi_right_switch, RIGHT_SWITCH_SPI, RIGHT_SWITCH_I2C);
+    inputs |= PIN_IS_HIGH(LEFT_BUTTON) ? 0 : COWPI_LEFT_BUTTON_INPUT;
+    inputs |= PIN_IS_HIGH(RIGHT_BUTTON) ? 0 : COWPI_RIGHT_BUTTON_INPUT;
+    inputs |= left_switch_is_right ? COWPI_LEFT_SWITCH_INPUT : 0;
+    inputs |= right_switch_is_right ? COWPI_RIGHT_SWITCH_INPUT : 0;
+    return inputs;
+}
+
+#elif defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040)
+
+#define PIN_IS_HIGH(pin) ((input & (1uL << (pin))) != 0)
+
+static uint32_t read_inputs(uint32_t inputs) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    uint32_t input = ioport->input;
+    // each switch has only one possible pin
+    inputs |= PIN_IS_HIGH(LEFT_BUTTON) ? 0 : COWPI_LEFT_BUTTON_INPUT;
+    inputs |= PIN_IS_HIGH(RIGHT_BUTTON) ? 0 : COWPI_RIGHT_BUTTON_INPUT;
+    inputs |= PIN_IS_HIGH(LEFT_SWITCH) ? COWPI_LEFT_SWITCH_INPUT : 0;
+    inputs |= PIN_IS_HIGH(RIGHT_SWITCH) ? COWPI_RIGHT_SWITCH_INPUT : 0;
+    return inputs;
+}
+
+#else
+
+static uint32_t read_inputs(uint32_t inputs) {
+    inputs |= cowpi_left_button_is_pressed() ? COWPI_LEFT_BUTTON_INPUT : 0;
+    inputs |= cowpi_right_button_is_pressed() ? COWPI_RIGHT_BUTTON_INPUT : 0;
+    inputs |= cowpi_left_switch_is_in_right_position() ? COWPI_LEFT_SWITCH_INPUT : 0;
+    inputs |= cowpi_right_switch_is_in_right_position() ? COWPI_RIGHT_SWITCH_INPUT : 0;
+    return inputs;
+}
+
+#endif //MICROCONTROLLER
+
+uint32_t cowpi_read_inputs(void) {
+    return read_inputs(cowpi_get_keypresses());
+}
+
+
+/* Background sampling */
+
+/*
+ * Scanning the keypad from the timer interrupt could interrupt a scan in loop() between driving a row LOW and reading
+ * the columns, leaving the rows in the wrong state for both scans. While the inputs are sampled, the keypad is
+ * therefore scanned only by the timer interrupt (unless it is scanned in the background or is interrupt-driven, which
+ * never conflicts with loop()), and polling the keypad examines the most recent sample.
+ */
+
+static bool volatile input_sampling_is_enabled = false;
+static cowpi_vertical_debouncer_t input_debouncer;
+
+#define PACKED_INPUTS (20)
+#define ALL_PACKED_INPUTS ((1uL << PACKED_INPUTS) - 1)
+
+// the snapshot and the change times are written only while snapshot_sequence is odd, and are consistent only while it
+// is even
+static cowpi_input_snapshot_t volatile snapshot = {0, 0, 0};
+static uint8_t volatile snapshot_sequence = 0;
+
+// the lower 16 bits of millis() when each packed input last changed, as with cowpi_debouncer_t
+static uint16_t volatile change_times[PACKED_INPUTS];
+
+static void record_change_times(uint32_t changes, unsigned long now) {
+    changes &= ALL_PACKED_INPUTS;
+    while (changes) {
+        change_times[__builtin_ctzl(changes)] = (uint16_t) now;
+        changes &= changes - 1;         // clear the lowest 1 bit
+    }
+}
+
+// must be called from the ISR or while the ISR cannot sample the inputs
+static void publish_snapshot(uint32_t inputs, uint32_t changes) {
+    unsigned long now = millis();
+    snapshot_sequence++;
+    MEMORY_BARRIER();
+    snapshot.inputs = inputs;
+    snapshot.timestamp = now;
+    if (changes) {
+        snapshot.last_change = now;
+        record_change_times(changes, now);
+    }
+    MEMORY_BARRIER();
+    snapshot_sequence++;
+}
+
+static void sample_inputs(void) {
+    if (!input_sampling_is_enabled) {
+        return;
+    }
+    uint32_t inputs = cowpi_debounce_vertically(&input_debouncer, read_inputs(cowpi_sample_keypresses()));
+    publish_snapshot(inputs, input_debouncer.rising | input_debouncer.falling);
+}
+
+static void start_input_sampling(void) {
+    input_sampling_is_enabled = false;
+    cowpi_enable_keypad_sampling();
+    uint32_t inputs = read_inputs(cowpi_sample_keypresses());
+    // start from the current inputs so that the first samples don't report every input that is already 1
+    input_debouncer = (cowpi_vertical_debouncer_t) {.state = inputs};
+    publish_snapshot(inputs, ALL_PACKED_INPUTS);
+    input_sampling_is_enabled = true;
+}
+
+#if defined (__AVR__)
+
+bool cowpi_enable_input_sampling(unsigned int timer_number, unsigned int isr_slot) {
+    start_input_sampling();
+    if (!register_periodic_ISR(timer_number, isr_slot, sample_inputs)) {
+        cowpi_disable_input_sampling();
+        return false;
+    }
+    return true;
+}
+
+#endif //__AVR__
+
+#ifdef __MBED__
+
+bool cowpi_enable_input_sampling(unsigned int timer_number, uint32_t period_us) {
+    start_input_sampling();
+    if (!register_periodic_ISR(timer_number, period_us, sample_inputs)) {
+        cowpi_disable_input_sampling();
+        return false;
+    }
+    return true;
+}
+
+#endif //__MBED__
+
+void cowpi_disable_input_sampling(void) {
+    input_sampling_is_enabled = false;
+    cowpi_disable_keypad_sampling();
+}
+
+
+/* Snapshots and changes */
+
+void cowpi_get_input_snapshot(cowpi_input_snapshot_t *destination) {
+    uint8_t sequence;
+    do {
+        sequence = snapshot_sequence;
+        MEMORY_BARRIER();
+        destination->inputs = snapshot.inputs;
+        destination->timestamp = snapshot.timestamp;
+        destination->last_change = snapshot.last_change;
+        MEMORY_BARRIER();
+    } while ((sequence & 0x1) || sequence != snapshot_sequence);
+}
+
+uint32_t cowpi_get_input_changes(cowpi_input_changes_t *changes) {
+    static uint32_t previous_inputs = 0;
+    static unsigned long previous_change = 0;
+    uint32_t inputs;
+    if (input_sampling_is_enabled) {
+        cowpi_input_snapshot_t current;
+        cowpi_get_input_snapshot(&current);
+        inputs = current.inputs;
+        previous_change = current.last_change;
+    } else {
+        inputs = cowpi_read_inputs();
+        if (inputs != previous_inputs) {
+            previous_change = millis();
+            record_change_times(inputs ^ previous_inputs, previous_change);
+        }
+    }
+    changes->inputs = inputs;
+    changes->pressed = inputs & ~previous_inputs;
+    changes->released = ~inputs & previous_inputs;
+    changes->toggled = inputs ^ previous_inputs;
+    changes->timestamp = previous_change;
+    previous_inputs = inputs;
+    return changes->toggled;
+}
+
+unsigned long cowpi_get_input_change_time(uint32_t input) {
+    input &= ALL_PACKED_INPUTS;
+    if (!input) {
+        return 0;
+    }
+    uint8_t bit = __builtin_ctzl(input);
+    uint16_t change_time;
+    uint8_t sequence;
+    do {
+        sequence = snapshot_sequence;
+        MEMORY_BARRIER();
+        change_time = change_times[bit];
+        MEMORY_BARRIER();
+    } while ((sequence & 0x1) || sequence != snapshot_sequence);
+    // 16-bit differences are correct across the 16-bit wraparound, as long as they are less than 65536ms
+    unsigned long now = millis();
+    return now - (uint16_t) ((uint16_t) now - change_time);
+}
@@ -0,0 +1,252 @@
+/**************************************************************************//**
+ *
+ * @file inputs.h
+ *
+ * @author Christopher A. Bohn
+ *
+ * @brief Defines the functions to read every button, switch, and key at once,
+ * to sample them from a timer interrupt, and to obtain a consistent snapshot
+ * of the debounced inputs.
+ *
+ * All of the Cow Pi's inputs are packed into a single 32-bit word. The keypad
+ * occupies the lower 16 bits, using the same bit positions as
+ * `cowpi_get_keypresses()`, and the buttons and switches occupy the bits
+ * described by `COWPI_LEFT_BUTTON_INPUT` and its siblings.
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COWPI_INPUTS_H
+#define COWPI_INPUTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COWPI_KEYPAD_INPUTS         (0x0000FFFFuL)  //!< The bits of the packed inputs that hold the keypad's keys
+#define COWPI_LEFT_BUTTON_INPUT     (1uL << 16)     //!< The bit of the packed inputs that is 1 when the left button is pressed
+#define COWPI_RIGHT_BUTTON_INPUT    (1uL << 17)     //!< The bit of the packed inputs that is 1 when the right button is pressed
+#define COWPI_LEFT_SWITCH_INPUT     (1uL << 18)     //!< The bit of the packed inputs that is 1 when the left switch is in the right position
+#define COWPI_RIGHT_SWITCH_INPUT    (1uL << 19)     //!< The bit of the packed inputs that is 1 when the right switch is in the right position
+
+/**
+ * @brief Reads every button, switch, and key, and packs them into one word.
+ *
+ * There is no debouncing. On the ATmega328P, the ATmega2560, and the RP2040,
+ * each I/O port is read only once for the buttons and switches, using
+ * memory-mapped I/O; on other microcontrollers, this is a portable
+ * implementation. The keypad is
+ * read with `cowpi_get_keypresses()`, which requires one read per row unless
+ * the keypad is being scanned in the background, is interrupt-driven, or is
+ * sampled with the other inputs.
+ *
+ * @sa cowpi_get_keypresses
+ *
+ * @return the packed inputs
+ */
+uint32_t cowpi_read_inputs(void);
+
+/**
+ * @brief The debounced state of every input, as of one timer interrupt.
+ */
+typedef struct {
+    uint32_t inputs;                    //!< The packed, debounced inputs
+    unsigned long timestamp;            //!< The value of `millis()` when the inputs were sampled
+    unsigned long last_change;          //!< The value of `millis()` when the debounced inputs last changed
+} cowpi_input_snapshot_t;
+
+/**
+ * @brief The inputs that have changed since the previous call to
+ * `cowpi_get_input_changes()`.
+ */
+typedef struct {
+    uint32_t inputs;                    //!< The packed inputs
+    uint32_t pressed;                   //!< The inputs that changed from 0 to 1
+    uint32_t released;                  //!< The inputs that changed from 1 to 0
+    uint32_t toggled;                   //!< The inputs that changed in either direction
+    unsigned long timestamp;            //!< The value of `millis()` when the most recent change occurred
+} cowpi_input_changes_t;
+
+#if defined (__AVR__)
+
+/**
+ * @brief Samples and debounces every input in the background, once per timer
+ * interrupt.
+ *
+ * Each time the timer's interrupt fires, every button, switch, and key is
+ * sampled and debounced with `cowpi_debounce_vertically()`; a change is
+ * reported only after it has been seen in four consecutive samples. A timer
+ * period of 5ms requires an input to be stable for 20ms.
+ *
+ * Unless the keypad is scanned in the background
+ * (`cowpi_enable_keypad_scanning()`) or, on the Arduino Uno and Arduino Nano,
+ * by interrupts (`cowpi_enable_keypad_interrupts()`), the timer interrupt
+ * scans the keypad with the other inputs. So that a scan by the timer
+ * interrupt cannot corrupt a scan in `loop()`, `cowpi_get_keypress()` and
+ * `cowpi_get_keypresses()` then examine the most recent sample instead of
+ * scanning the keypad, until `cowpi_disable_input_sampling()` is called.
+ *
+ * Because the inputs are sampled at a fixed rate, debouncing does not depend on
+ * how often the program polls the inputs. The most recent sample is retrieved
+ * with `cowpi_get_input_snapshot()`.
+ *
+ * The timer must have previously been configured using `configure_timer()`.
+ *
+ * @sa register_periodic_ISR
+ *
+ * @param timer_number The timer whose interrupt will sample the inputs
+ * @param isr_slot The ISR slot to use to sample the inputs
+ * @return `true` if the background sampling was successfully started;
+ *      `false` otherwise
+ */
+bool cowpi_enable_input_sampling(unsigned int timer_number, unsigned int isr_slot) __attribute__ ((warn_unused_result));
+
+#endif //__AVR__
+
+#ifdef __MBED__
+
+/**
+ * @brief Samples and debounces every input in the background, once per timer
+ * interrupt.
+ *
+ * Each time the timer's interrupt fires, every button, switch, and key is
+ * sampled and debounced with `cowpi_debounce_vertically()`; a change is
+ * reported only after it has been seen in four consecutive samples. A period
+ * of 5000us requires an input to be stable for 20ms.
+ *
+ * Unless the keypad is scanned in the background
+ * (`cowpi_enable_keypad_scanning()`) or, on the Arduino Uno and Arduino Nano,
+ * by interrupts (`cowpi_enable_keypad_interrupts()`), the timer interrupt
+ * scans the keypad with the other inputs. So that a scan by the timer
+ * interrupt cannot corrupt a scan in `loop()`, `cowpi_get_keypress()` and
+ * `cowpi_get_keypresses()` then examine the most recent sample instead of
+ * scanning the keypad, until `cowpi_disable_input_sampling()` is called.
+ *
+ * Because the inputs are sampled at a fixed rate, debouncing does not depend on
+ * how often the program polls the inputs. The most recent sample is retrieved
+ * with `cowpi_get_input_snapshot()`.
+ *
+ * Any ISR that had previously been registered for the timer will be
+ * deregistered.
+ *
+ * @sa register_periodic_ISR
+ *
+ * @param timer_number A unique handle for the virtual periodic timer that will
+ *      sample the inputs
+ * @param period_us The time between samples
+ * @return `true` if the background sampling was successfully started;
+ *      `false` otherwise
+ */
+bool cowpi_enable_input_sampling(unsigned int timer_number, uint32_t period_us) __attribute__ ((warn_unused_result));
+
+#endif //__MBED__
+
+/**
+ * @brief Stops sampling the inputs in the background.
+ *
+ * The timer interrupt will continue to fire but will no longer sample the
+ * inputs. The most recent snapshot remains available to
+ * `cowpi_get_input_snapshot()`.
+ */
+void cowpi_disable_input_sampling(void);
+
+/**
+ * @brief Retrieves the most recent debounced sample of every input.
+ *
+ * The snapshot is protected by a sequence lock: if the timer interrupt
+ * publishes a new sample while the snapshot is being copied, the copy is
+ * repeated, so the snapshot is always consistent without disabling
+ * interrupts. On a 16MHz ATmega328P, copying the snapshot takes approximately
+ * 30 cycles, estimated from the instruction sequence, no matter how long it
+ * has been since the inputs were last retrieved.
+ *
+ * @param snapshot Pointer to the structure that will receive the snapshot
+ */
+void cowpi_get_input_snapshot(cowpi_input_snapshot_t *snapshot);
+
+/**
+ * @brief Determines which inputs have changed since this function was last
+ * called.
+ *
+ * Compares the current inputs to the inputs from the previous call and reports
+ * which inputs changed from 0 to 1 (`pressed`), which changed from 1 to 0
+ * (`released`), and which changed at all (`toggled`), along with the time of
+ * the most recent change. Because the toggled inputs are also returned, a
+ * program can skip all of its input handling when this function returns 0:
+ * @code
+ * cowpi_input_changes_t changes;
+ * if (cowpi_get_input_changes(&changes)) {
+ *     if (changes.pressed & COWPI_LEFT_BUTTON_INPUT) {
+ *         ...
+ *     }
+ * }
+ * @endcode
+ *
+ * If the inputs are being sampled in the background, then the most recent
+ * snapshot is used, and the timestamp is the time that the debounced inputs
+ * changed, even if this function was not called until much later. Otherwise,
+ * the inputs are read (without debouncing) with `cowpi_read_inputs()`, and the
+ * timestamp is the time of the call that first saw the change.
+ *
+ * The timestamp is only the time of the most recent change; when several
+ * inputs change between two calls, the time that each of them changed is
+ * available from `cowpi_get_input_change_time()`.
+ *
+ * The first call reports every input that is 1 as having been pressed.
+ *
+ * @note An input that changes and then changes back between two calls is not
+ *      reported.
+ *
+ * @param changes Pointer to the structure that will receive the changes
+ * @return the inputs that changed in either direction
+ */
+uint32_t cowpi_get_input_changes(cowpi_input_changes_t *changes);
+
+/**
+ * @brief Reports when an input last changed.
+ *
+ * If the inputs are being sampled in the background, then the time is when
+ * the debounced input changed. Otherwise, the time is that of the
+ * `cowpi_get_input_changes()` call that first saw the change. For example, the
+ * time that the left button was pressed and the time that the right button
+ * was released can both be recovered after a single call:
+ * @code
+ * if (changes.pressed & COWPI_LEFT_BUTTON_INPUT) {
+ *     press_time = cowpi_get_input_change_time(COWPI_LEFT_BUTTON_INPUT);
+ * }
+ * if (changes.released & COWPI_RIGHT_BUTTON_INPUT) {
+ *     release_time = cowpi_get_input_change_time(COWPI_RIGHT_BUTTON_INPUT);
+ * }
+ * @endcode
+ *
+ * Each input's change time is kept as the lower 16 bits of `millis()`, and so
+ * the time is correct only if the input changed within the last 65 seconds;
+ * an older change is reported as some time within the last 65 seconds.
+ *
+ * @param input One of the packed inputs, such as `COWPI_LEFT_BUTTON_INPUT`; if
+ *      more than one bit is set, the lowest is used
+ * @return the value of `millis()` when the input last changed, or 0 if no
+ *      packed input is specified
+ */
+unsigned long cowpi_get_input_change_time(uint32_t input);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif //COWPI_INPUTS_H
@@ -0,0 +1,739 @@
+/**************************************************************************//**
+ *
+ * @file keypad.c
+ *
+ * @brief @copybrief keypad.h
+ *
+ * @details @copydetails keypad.h
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include "cowpi_io.h"
+#include "keypad.h"
+#include "../internal/cowpi_internal.h"
+#include "../boards/boards.h"
+#include "../interrupts/pin_interrupts.h"
+#include "../interrupts/timer_interrupts.h"
+
+#if defined (__AVR__)
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif //PROGMEM
+#ifndef pgm_read_byte
+#define pgm_read_byte(address) (*(uint8_t const *) (address))
+#endif //pgm_read_byte
+#ifndef pgm_read_word
+#define pgm_read_word(address) (*(uint16_t const *) (address))
+#endif //pgm_read_word
+#endif //__AVR__
+
+
+/* Keypad geometry */
+
+/*
+ * The keypad is described by COWPI_KEYPAD_ROW_PINS, COWPI_KEYPAD_COLUMN_PINS, and COWPI_KEYPAD_LEGEND (see keypad.h).
+ * Everything below is derived from that description by the preprocessor and the compiler: the port masks and decode
+ * tables are constants, and no pin is looked up while scanning.
+ */
+
+#define COUNT_PIN(pin) + 1
+#define KEYPAD_ROWS     (0 COWPI_KEYPAD_ROW_PINS(COUNT_PIN))
+#define KEYPAD_COLUMNS  (0 COWPI_KEYPAD_COLUMN_PINS(COUNT_PIN))
+#define KEYPAD_KEYS     (KEYPAD_ROWS * KEYPAD_COLUMNS)
+
+#define ALL_KEYPAD_ROWS     ((1 << KEYPAD_ROWS) - 1)
+#define ALL_KEYPAD_COLUMNS  ((1 << KEYPAD_COLUMNS) - 1)
+
+_Static_assert(KEYPAD_ROWS > 0 && KEYPAD_ROWS <= 8, "The keypad must have between 1 and 8 rows");
+_Static_assert(KEYPAD_COLUMNS > 0 && KEYPAD_COLUMNS <= 8, "The keypad must have between 1 and 8 columns");
+_Static_assert(KEYPAD_KEYS <= 16, "The keypad must have no more than 16 keys, one per bit of cowpi_get_keypresses()");
+_Static_assert(sizeof(COWPI_KEYPAD_LEGEND) - 1 == KEYPAD_KEYS, "COWPI_KEYPAD_LEGEND must have one character per key");
+
+// bit (KEYPAD_COLUMNS * row + column) of the raw matrix is 1 if and only if the key at that row and column is pressed
+typedef uint16_t keypad_matrix_t;
+
+// the character depicted on the key at each position in the raw matrix
+static char const keypad_legend[KEYPAD_KEYS + 1] PROGMEM = COWPI_KEYPAD_LEGEND;
+
+// the character depicted on the key at a position in the raw matrix, as a constant expression
+#define LEGEND(position) (COWPI_KEYPAD_LEGEND[(position) < KEYPAD_KEYS ? (position) : 0])
+
+// bit vector (as reported by cowpi_get_keypresses) for the key depicted by a character; 0 if the key has no bit
+#define KEY_FLAG(c)                                                                                             \
+        (((c) >= '0' && (c) <= '9') ? (1u << ((c) - '0'))                                                       \
+       : ((c) >= 'A' && (c) <= 'D') ? (1u << ((c) - 'A' + 0xA))                                                 \
+       : ((c) == '#') ? (1u << 0xE)                                                                             \
+       : ((c) == '*') ? (1u << 0xF)                                                                             \
+       : 0)
+
+/*
+ * Every key must have its own bit in cowpi_get_keypresses(): each character of COWPI_KEYPAD_LEGEND must be a digit,
+ * A-D, #, or *, and no character may appear twice (the sum of distinct bits is also their bitwise OR). A character in
+ * a string literal is not an integer constant expression, so this can't be a _Static_assert; instead, a legend that
+ * breaks these rules divides by zero in a constant initializer, which is a compile-time error.
+ */
+#define KEY_FLAG_OR_0(position)  ((position) < KEYPAD_KEYS ? KEY_FLAG(LEGEND(position)) : 0)
+#define KEY_HAS_FLAG(position)   ((position) >= KEYPAD_KEYS || KEY_FLAG(LEGEND(position)) != 0)
+#define KEY_FLAGS_SUM    (KEY_FLAG_OR_0(0x0) + KEY_FLAG_OR_0(0x1) + KEY_FLAG_OR_0(0x2) + KEY_FLAG_OR_0(0x3)         \
+                          + KEY_FLAG_OR_0(0x4) + KEY_FLAG_OR_0(0x5) + KEY_FLAG_OR_0(0x6) + KEY_FLAG_OR_0(0x7)       \
+                          + KEY_FLAG_OR_0(0x8) + KEY_FLAG_OR_0(0x9) + KEY_FLAG_OR_0(0xA) + KEY_FLAG_OR_0(0xB)       \
+                          + KEY_FLAG_OR_0(0xC) + KEY_FLAG_OR_0(0xD) + KEY_FLAG_OR_0(0xE) + KEY_FLAG_OR_0(0xF))
+#define KEY_FLAGS_OR     (KEY_FLAG_OR_0(0x0) | KEY_FLAG_OR_0(0x1) | KEY_FLAG_OR_0(0x2) | KEY_FLAG_OR_0(0x3)         \
+                          | KEY_FLAG_OR_0(0x4) | KEY_FLAG_OR_0(0x5) | KEY_FLAG_OR_0(0x6) | KEY_FLAG_OR_0(0x7)       \
+                          | KEY_FLAG_OR_0(0x8) | KEY_FLAG_OR_0(0x9) | KEY_FLAG_OR_0(0xA) | KEY_FLAG_OR_0(0xB)       \
+                          | KEY_FLAG_OR_0(0xC) | KEY_FLAG_OR_0(0xD) | KEY_FLAG_OR_0(0xE) | KEY_FLAG_OR_0(0xF))
+#define EVERY_KEY_HAS_FLAG                                                                                      \
+        (KEY_HAS_FLAG(0x0) && KEY_HAS_FLAG(0x1) && KEY_HAS_FLAG(0x2) && KEY_HAS_FLAG(0x3)                       \
+         && KEY_HAS_FLAG(0x4) && KEY_HAS_FLAG(0x5) && KEY_HAS_FLAG(0x6) && KEY_HAS_FLAG(0x7)                    \
+         && KEY_HAS_FLAG(0x8) && KEY_HAS_FLAG(0x9) && KEY_HAS_FLAG(0xA) && KEY_HAS_FLAG(0xB)                    \
+         && KEY_HAS_FLAG(0xC) && KEY_HAS_FLAG(0xD) && KEY_HAS_FLAG(0xE) && KEY_HAS_FLAG(0xF))
+static uint8_t const each_key_must_have_its_own_bit __attribute__ ((unused))
+        = 1 / (EVERY_KEY_HAS_FLAG && KEY_FLAGS_SUM == KEY_FLAGS_OR);
+
+
+/* Keypad hardware access */
+
+/*
+ * set_keypad_rows() drives LOW each row whose bit is 1 in `low_rows` and drives HIGH each row whose bit is 0. Rows are
+ * numbered from 0 in the order they are listed in COWPI_KEYPAD_ROW_PINS.
+ *
+ * get_keypad_columns() returns a bit vector with a 1 in each column that is LOW (that is, a column with a pressed key
+ * in a row that is LOW). Columns are numbered from 0 in the order they are listed in COWPI_KEYPAD_COLUMN_PINS.
+ *
+ * KEYPAD_SETTLE() allows time for newly-driven rows to be visible on the columns.
+ */
+
+#if defined (__AVR_ATmega328P__)
+
+#define KEYPAD_SETTLE() __asm__ __volatile__ ("nop")    // give the input synchronizer time to latch the column values
+
+// the keypad's pins in each port
+#define IF_IN_PB(pin) | ((COWPI_PIN_PORT(pin) == COWPI_PB) ? COWPI_PIN_MASK(pin) : 0)
+#define IF_IN_PC(pin) | ((COWPI_PIN_PORT(pin) == COWPI_PC) ? COWPI_PIN_MASK(pin) : 0)
+#define IF_IN_PD(pin) | ((COWPI_PIN_PORT(pin) == COWPI_PD) ? COWPI_PIN_MASK(pin) : 0)
+#define ROWS_IN_PB      ((uint8_t) (0 COWPI_KEYPAD_ROW_PINS(IF_IN_PB)))
+#define ROWS_IN_PC      ((uint8_t) (0 COWPI_KEYPAD_ROW_PINS(IF_IN_PC)))
+#define ROWS_IN_PD      ((uint8_t) (0 COWPI_KEYPAD_ROW_PINS(IF_IN_PD)))
+#define COLUMNS_IN_PB   ((uint8_t) (0 COWPI_KEYPAD_COLUMN_PINS(IF_IN_PB)))
+#define COLUMNS_IN_PC   ((uint8_t) (0 COWPI_KEYPAD_COLUMN_PINS(IF_IN_PC)))
+#define COLUMNS_IN_PD   ((uint8_t) (0 COWPI_KEYPAD_COLUMN_PINS(IF_IN_PD)))
+
+static inline void set_keypad_rows(uint8_t low_rows) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    uint8_t low[3] = {0, 0, 0};
+#define ROW_LOW(pin) low[COWPI_PIN_PORT(pin)] |= (low_rows & 0x1) ? COWPI_PIN_MASK(pin) : 0; low_rows >>= 1;
+    COWPI_KEYPAD_ROW_PINS(ROW_LOW)
+#undef ROW_LOW
+    // only the ports with rows are written, each with a single read-modify-write
+#define WRITE_ROWS(port, rows) if (rows) ioports[port].output = (ioports[port].output & ~(rows)) | ((rows) & ~low[port]);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {     // the ports' other pins might be changed by an ISR
+        WRITE_ROWS(COWPI_PB, ROWS_IN_PB)
+        WRITE_ROWS(COWPI_PC, ROWS_IN_PC)
+        WRITE_ROWS(COWPI_PD, ROWS_IN_PD)
+    }
+#undef WRITE_ROWS
+}
+
+static inline uint8_t get_keypad_columns(void) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    uint8_t input[3];
+    // only the ports with columns are read
+    input[COWPI_PB] = COLUMNS_IN_PB ? ioports[COWPI_PB].input : 0;
+    input[COWPI_PC] = COLUMNS_IN_PC ? ioports[COWPI_PC].input : 0;
+    input[COWPI_PD] = COLUMNS_IN_PD ? ioports[COWPI_PD].input : 0;
+    uint8_t const last_column = 1 << (KEYPAD_COLUMNS - 1);     // each column is shifted in from here
+    uint8_t columns = 0;
+#define READ_COLUMN(pin) \
+        columns = (uint8_t) ((columns >> 1) | ((input[COWPI_PIN_PORT(pin)] & COWPI_PIN_MASK(pin)) ? 0 : last_column));
+    COWPI_KEYPAD_COLUMN_PINS(READ_COLUMN)
+#undef READ_COLUMN
+    return columns;
+}
+
+#elif defined (__AVR_ATmega2560__)
+
+#define KEYPAD_SETTLE() __asm__ __volatile__ ("nop")    // give the input synchronizer time to latch the column values
+
+// the keypad's pins can be in any of the eleven ports; a port without any of them is never accessed
+#define FOR_EACH_PORT(PORT) PORT(COWPI_PA) PORT(COWPI_PB) PORT(COWPI_PC) PORT(COWPI_PD) PORT(COWPI_PE) PORT(COWPI_PF) \
+                            PORT(COWPI_PG) PORT(COWPI_PH) PORT(COWPI_PJ) PORT(COWPI_PK) PORT(COWPI_PL)
+
+// the keypad's pins in a port; with a constant port, these reduce to constants
+static inline __attribute__ ((always_inline)) uint8_t rows_in_port(uint8_t port) {
+    uint8_t rows = 0;
+#define ROW_IN_PORT(pin) rows |= (COWPI_PIN_PORT(pin) == port) ? COWPI_PIN_MASK(pin) : 0;
+    COWPI_KEYPAD_ROW_PINS(ROW_IN_PORT)
+#undef ROW_IN_PORT
+    return rows;
+}
+
+static inline __attribute__ ((always_inline)) uint8_t columns_in_port(uint8_t port) {
+    uint8_t columns = 0;
+#define COLUMN_IN_PORT(pin) columns |= (COWPI_PIN_PORT(pin) == port) ? COWPI_PIN_MASK(pin) : 0;
+    COWPI_KEYPAD_COLUMN_PINS(COLUMN_IN_PORT)
+#undef COLUMN_IN_PORT
+    return columns;
+}
+
+static inline void set_keypad_rows(uint8_t low_rows) {
+    uint8_t low[COWPI_NUMBER_OF_PORTS] = {0};
+#define ROW_LOW(pin) low[COWPI_PIN_PORT(pin)] |= (low_rows & 0x1) ? COWPI_PIN_MASK(pin) : 0; low_rows >>= 1;
+    COWPI_KEYPAD_ROW_PINS(ROW_LOW)
+#undef ROW_LOW
+    // only the ports with rows are written, each with a single read-modify-write
+#define WRITE_ROWS(port) if (rows_in_port(port)) COWPI_IOPORT(port)->output =                                     \
+        (COWPI_IOPORT(port)->output & ~rows_in_port(port)) | (rows_in_port(port) & ~low[port]);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {     // the ports' other pins might be changed by an ISR
+        FOR_EACH_PORT(WRITE_ROWS)
+    }
+#undef WRITE_ROWS
+}
+
+static inline uint8_t get_keypad_columns(void) {
+    uint8_t input[COWPI_NUMBER_OF_PORTS];
+    // only the ports with columns are read
+#define READ_COLUMNS(port) input[port] = columns_in_port(port) ? COWPI_IOPORT(port)->input : 0;
+    FOR_EACH_PORT(READ_COLUMNS)
+#undef READ_COLUMNS
+    uint8_t const last_column = 1 << (KEYPAD_COLUMNS - 1);     // each column is shifted in from here
+    uint8_t columns = 0;
+#define READ_COLUMN(pin) \
+        columns = (uint8_t) ((columns >> 1) | ((input[COWPI_PIN_PORT(pin)] & COWPI_PIN_MASK(pin)) ? 0 : last_column));
+    COWPI_KEYPAD_COLUMN_PINS(READ_COLUMN)
+#undef READ_COLUMN
+    return columns;
+}
+
+#elif defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040)
+
+#define KEYPAD_SETTLE() __asm__ __volatile__ ("nop\n\tnop\n\tnop")  // give the input synchronizer time to latch the column values
+
+#define PIN_BIT(pin) | (1uL << (pin))
+#define KEYPAD_ROW_PINS ((uint32_t) (0 COWPI_KEYPAD_ROW_PINS(PIN_BIT)))
+
+static inline void set_keypad_rows(uint8_t low_rows) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    uint32_t low = 0;
+#define ROW_LOW(pin) low |= (low_rows & 0x1) ? (1uL << (pin)) : 0; low_rows >>= 1;
+    COWPI_KEYPAD_ROW_PINS(ROW_LOW)
+#undef ROW_LOW
+    ioport->atomic_set = KEYPAD_ROW_PINS & ~low;
+    ioport->atomic_clear = low;
+}
+
+static inline uint8_t get_keypad_columns(void) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    uint32_t input = ioport->input;
+    uint8_t const last_column = 1 << (KEYPAD_COLUMNS - 1);     // each column is shifted in from here
+    uint8_t columns = 0;
+#define READ_COLUMN(pin) columns = (uint8_t) ((columns >> 1) | ((input & (1uL << (pin))) ? 0 : last_column));
+    COWPI_KEYPAD_COLUMN_PINS(READ_COLUMN)
+#undef READ_COLUMN
+    return columns;
+}
+
+#else
+
+#define KEYPAD_SETTLE() do {} while (0)
+
+static inline void set_keypad_rows(uint8_t low_rows) {
+#define DRIVE_ROW(pin) digitalWrite(pin, (low_rows & 0x1) ? LOW : HIGH); low_rows >>= 1;
+    COWPI_KEYPAD_ROW_PINS(DRIVE_ROW)
+#undef DRIVE_ROW
+}
+
+static inline uint8_t get_keypad_columns(void) {
+    uint8_t const last_column = 1 << (KEYPAD_COLUMNS - 1);     // each column is shifted in from here
+    uint8_t columns = 0;
+#define READ_COLUMN(pin) columns = (uint8_t) ((columns >> 1) | (digitalRead(pin) ? 0 : last_column));
+    COWPI_KEYPAD_COLUMN_PINS(READ_COLUMN)
+#undef READ_COLUMN
+    return columns;
+}
+
+#endif //MICROCONTROLLER
+
+/*
+ * Scans the keypad one row at a time and returns the raw matrix. All rows are left LOW so that any keypress will pull a
+ * column LOW, which allows pin change interrupts to detect keypresses. Each row's columns are shifted in from the top
+ * of the matrix so that every shift is by a constant distance.
+ *
+ * Approximate cost of a full 16-key scan on a 16MHz ATmega328P, estimated from the instruction sequences:
+ *  - digitalWrite/digitalRead for each probed key (64 writes + 16 reads, plus 4 writes to restore the rows):
+ *    about 5000 cycles (~310us)
+ *  - direct register access (4 writes to PORTD + 4 reads from PINC, plus 1 write to restore the rows):
+ *    about 100 cycles (~6us)
+ */
+static keypad_matrix_t scan_keypad(void) {
+    keypad_matrix_t matrix = 0;
+    for (uint8_t row = 0; row < KEYPAD_ROWS; row++) {
+        set_keypad_rows(1 << row);
+        KEYPAD_SETTLE();
+        matrix = (matrix >> KEYPAD_COLUMNS)
+                 | ((keypad_matrix_t) get_keypad_columns() << (KEYPAD_COLUMNS * (KEYPAD_ROWS - 1)));
+    }
+    set_keypad_rows(ALL_KEYPAD_ROWS);
+    return matrix;
+}
+
+// the columns that have at least one pressed key
+static uint8_t get_pressed_columns(keypad_matrix_t m) {
+    uint8_t columns = 0;
+    for (uint8_t row = 0; row < KEYPAD_ROWS; row++) {
+        columns |= m & ALL_KEYPAD_COLUMNS;
+        m >>= KEYPAD_COLUMNS;
+    }
+    return columns;
+}
+
+
+/* Keypad decoding */
+
+/*
+ * Both decoders take a fixed amount of time, regardless of which keys are pressed: there are no data-dependent loops
+ * or branches. For a 4x4 keypad, the decoders use lookup tables; other geometries examine every key in a fixed order.
+ *
+ * Estimated cost of decoding on a 16MHz ATmega328P, not counting the scan; these are counted from the instruction
+ * sequences, not measured:
+ *  - the switch statement that these replace dispatched each probed key in about 30 cycles: about 500 cycles to
+ *    collect every pressed key, and from about 30 cycles (the first key in probe order is pressed) to about 500 cycles
+ *    (no key is pressed) to find one key
+ *  - decode_keypresses(): about 60 cycles, and decode_keypress(): about 70 cycles, no matter which keys are pressed
+ */
+
+#if KEYPAD_ROWS == 4 && KEYPAD_COLUMNS == 4
+
+// bit vector (as reported by cowpi_get_keypresses) for the keys that are pressed in one row of the matrix
+#define ROW_KEYS(columns, row)                                                                                  \
+        ((((columns) & 0x1) ? KEY_FLAG(LEGEND(4 * (row) + 0)) : 0)                                              \
+       | (((columns) & 0x2) ? KEY_FLAG(LEGEND(4 * (row) + 1)) : 0)                                              \
+       | (((columns) & 0x4) ? KEY_FLAG(LEGEND(4 * (row) + 2)) : 0)                                              \
+       | (((columns) & 0x8) ? KEY_FLAG(LEGEND(4 * (row) + 3)) : 0))
+
+#define ROW_TABLE(row) {                                                                                        \
+        ROW_KEYS(0x0, row), ROW_KEYS(0x1, row), ROW_KEYS(0x2, row), ROW_KEYS(0x3, row),                         \
+        ROW_KEYS(0x4, row), ROW_KEYS(0x5, row), ROW_KEYS(0x6, row), ROW_KEYS(0x7, row),                         \
+        ROW_KEYS(0x8, row), ROW_KEYS(0x9, row), ROW_KEYS(0xA, row), ROW_KEYS(0xB, row),                         \
+        ROW_KEYS(0xC, row), ROW_KEYS(0xD, row), ROW_KEYS(0xE, row), ROW_KEYS(0xF, row)                          \
+}
+
+// indexed by row, and then by the columns that are pressed in that row
+static uint16_t const keypresses_table[4][16] PROGMEM = {
+        ROW_TABLE(0), ROW_TABLE(1), ROW_TABLE(2), ROW_TABLE(3)
+};
+
+// the keys in the order that they had been probed by the original decoder: down each column, from left to right
+static char const keypress_legend[16] PROGMEM = {
+        LEGEND(0x0), LEGEND(0x4), LEGEND(0x8), LEGEND(0xC),
+        LEGEND(0x1), LEGEND(0x5), LEGEND(0x9), LEGEND(0xD),
+        LEGEND(0x2), LEGEND(0x6), LEGEND(0xA), LEGEND(0xE),
+        LEGEND(0x3), LEGEND(0x7), LEGEND(0xB), LEGEND(0xF)
+};
+
+// position of the lone 1 in a one-hot 16-bit word, indexed by the upper nibble of (word * DE_BRUIJN_16)
+#define DE_BRUIJN_16 (0x0F65u)
+static uint8_t const lowest_bit_position[16] PROGMEM = {0, 1, 11, 2, 14, 12, 8, 3, 15, 10, 13, 7, 9, 6, 5, 4};
+
+static char decode_keypress(uint16_t m) {
+    // transpose the 4x4 matrix so that each nibble is a column: the first key in probe order becomes the lowest 1
+    uint16_t t;
+    t = (m ^ (m >> 3)) & 0x0A0A;
+    m ^= t ^ (t << 3);
+    t = (m ^ (m >> 6)) & 0x00CC;
+    m ^= t ^ (t << 6);
+    uint16_t lowest_key = m & -m;
+    uint8_t position = pgm_read_byte(&lowest_bit_position[(uint16_t) (lowest_key * DE_BRUIJN_16) >> 12]);
+    uint8_t any_key = (uint8_t) (-((uint16_t) (m | -m) >> 15));   // 0xFF if any key is pressed, 0x00 otherwise
+    return (char) (pgm_read_byte(&keypress_legend[position]) & any_key);
+}
+
+static uint16_t decode_keypresses(uint16_t m) {
+    return pgm_read_word(&keypresses_table[0][(m >> 0) & 0xF])
+         | pgm_read_word(&keypresses_table[1][(m >> 4) & 0xF])
+         | pgm_read_word(&keypresses_table[2][(m >> 8) & 0xF])
+         | pgm_read_word(&keypresses_table[3][(m >> 12) & 0xF]);
+}
+
+#else
+
+#define KEY_FLAGS_8(position)                                                                                   \
+        KEY_FLAG(LEGEND((position) + 0)), KEY_FLAG(LEGEND((position) + 1)),                                     \
+        KEY_FLAG(LEGEND((position) + 2)), KEY_FLAG(LEGEND((position) + 3)),                                     \
+        KEY_FLAG(LEGEND((position) + 4)), KEY_FLAG(LEGEND((position) + 5)),                                     \
+        KEY_FLAG(LEGEND((position) + 6)), KEY_FLAG(LEGEND((position) + 7))
+
+// bit vector (as reported by cowpi_get_keypresses) for the key at each position in the raw matrix
+static uint16_t const key_flags[16] PROGMEM = {
+        KEY_FLAGS_8(0), KEY_FLAGS_8(8)
+};
+
+static char decode_keypress(keypad_matrix_t m) {
+    char key = '\0';
+    // examine the keys in reverse probe order (down each column, from left to right) so the first key in probe order
+    // is the one that remains
+    for (int8_t column = KEYPAD_COLUMNS - 1; column >= 0; column--) {
+        for (int8_t row = KEYPAD_ROWS - 1; row >= 0; row--) {
+            uint8_t position = KEYPAD_COLUMNS * row + column;
+            uint8_t pressed = (uint8_t) -(uint8_t) ((m >> position) & 0x1);
+            key = (char) ((key & ~pressed) | (pgm_read_byte(&keypad_legend[position]) & pressed));
+        }
+    }
+    return key;
+}
+
+static uint16_t decode_keypresses(keypad_matrix_t m) {
+    uint16_t keypresses = 0;
+    for (uint8_t position = 0; position < KEYPAD_KEYS; position++) {
+        keypresses |= pgm_read_word(&key_flags[position]) & (uint16_t) -(uint16_t) (m & 0x1);
+        m >>= 1;
+    }
+    return keypresses;
+}
+
+#endif //KEYPAD GEOMETRY
+
+/*
+ * Finds the keys in the raw matrix that might be phantom keypresses. Without isolating diodes, the keys that appear to
+ * be pressed form rectangular blocks (every row of a block connects to every column of that block through pressed
+ * keys), and a key is ambiguous exactly when its block has at least two rows and at least two columns -- that is, when
+ * it shares at least two columns with some other row. Every pair of rows is always examined in full.
+ */
+static keypad_matrix_t find_ambiguous_keys(keypad_matrix_t m) {
+    uint8_t rows[KEYPAD_ROWS];
+    uint8_t ambiguous[KEYPAD_ROWS];
+    for (uint8_t i = 0; i < KEYPAD_ROWS; i++) {
+        rows[i] = m & ALL_KEYPAD_COLUMNS;
+        ambiguous[i] = 0;
+        m >>= KEYPAD_COLUMNS;
+    }
+    for (uint8_t i = 0; i < KEYPAD_ROWS - 1; i++) {
+        for (uint8_t j = i + 1; j < KEYPAD_ROWS; j++) {
+            uint8_t shared_columns = rows[i] & rows[j];
+            // keep the shared columns only if there are at least two of them
+            shared_columns &= (uint8_t) -(uint8_t) ((shared_columns & (shared_columns - 1)) != 0);
+            ambiguous[i] |= shared_columns;
+            ambiguous[j] |= shared_columns;
+        }
+    }
+    keypad_matrix_t ambiguous_keys = 0;
+    for (uint8_t i = KEYPAD_ROWS; i > 0; i--) {
+        ambiguous_keys = (ambiguous_keys << KEYPAD_COLUMNS) | ambiguous[i - 1];
+    }
+    return ambiguous_keys;
+}
+
+
+/* Keypad events */
+
+static enum {
+    KEYPAD_IS_POLLED,
+    KEYPAD_IS_SCANNED_IN_BACKGROUND,
+    KEYPAD_IS_INTERRUPT_DRIVEN,
+    KEYPAD_IS_SAMPLED
+} volatile keypad_mode = KEYPAD_IS_POLLED;
+
+// while the inputs are sampled, the keypad is sampled with them instead of being polled
+static bool volatile keypad_sampling_is_enabled = false;
+#define IDLE_KEYPAD_MODE (keypad_sampling_is_enabled ? KEYPAD_IS_SAMPLED : KEYPAD_IS_POLLED)
+
+// the sampling interrupt must not scan the keypad while it is being scanned outside of an interrupt
+static inline void stop_sampled_scans(void) {
+    if (keypad_mode == KEYPAD_IS_SAMPLED) {
+        keypad_mode = KEYPAD_IS_POLLED;
+    }
+}
+
+static keypad_matrix_t volatile reported_matrix = 0;
+static char volatile reported_keypress = '\0';
+static uint16_t volatile reported_keypresses = 0;
+
+static cowpi_keypad_event_t volatile keypad_events[COWPI_KEYPAD_EVENT_BUFFER_SIZE];
+static uint8_t volatile keypad_events_head = 0;     // written only by report_keypad_matrix()
+static uint8_t volatile keypad_events_tail = 0;     // written only by cowpi_get_keypad_event()
+
+static void push_keypad_event(char key, bool pressed) {
+    uint8_t head = keypad_events_head;
+    uint8_t next = (head + 1) & (COWPI_KEYPAD_EVENT_BUFFER_SIZE - 1);
+    if (next != keypad_events_tail) {
+        keypad_events[head].key = key;
+        keypad_events[head].pressed = pressed;
+        keypad_events_head = next;      // publish the event only after it has been written
+    }
+}
+
+// must be called from an ISR or with interrupts disabled
+static void report_keypad_matrix(keypad_matrix_t matrix) {
+    keypad_matrix_t changes = matrix ^ reported_matrix;
+    keypad_matrix_t pressed = matrix;
+    for (uint8_t i = 0; i < KEYPAD_KEYS; i++) {
+        if (changes & 0x1) {
+            push_keypad_event((char) pgm_read_byte(&keypad_legend[i]), pressed & 0x1);
+        }
+        changes >>= 1;
+        pressed >>= 1;
+    }
+    reported_matrix = matrix;
+    reported_keypress = decode_keypress(matrix);
+    reported_keypresses = decode_keypresses(matrix);
+}
+
+static void reset_keypad_reports(keypad_matrix_t matrix) {
+    reported_matrix = matrix;
+    reported_keypress = decode_keypress(matrix);
+    reported_keypresses = decode_keypresses(matrix);
+}
+
+
+/* Background scanning */
+
+// the row being driven LOW, the rows scanned so far, and the previous complete scan; reset when scanning starts
+static uint8_t keypad_row = 0;
+static keypad_matrix_t partial_matrix = 0;
+static keypad_matrix_t previous_matrix = 0;
+
+static void scan_next_keypad_row(void) {
+    if (keypad_mode != KEYPAD_IS_SCANNED_IN_BACKGROUND) {
+        return;
+    }
+    // the row was driven LOW during the previous interrupt, so the columns have long since settled
+    partial_matrix = (partial_matrix >> KEYPAD_COLUMNS)
+                     | ((keypad_matrix_t) get_keypad_columns() << (KEYPAD_COLUMNS * (KEYPAD_ROWS - 1)));
+    keypad_row = (keypad_row + 1 < KEYPAD_ROWS) ? keypad_row + 1 : 0;
+    set_keypad_rows(1 << keypad_row);
+    if (keypad_row == 0) {
+        keypad_matrix_t matrix = partial_matrix;
+        partial_matrix = 0;
+        if (matrix == previous_matrix && matrix != reported_matrix) {
+            report_keypad_matrix(matrix);
+        }
+        previous_matrix = matrix;
+    }
+}
+
+static void start_keypad_scanning(void) {
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+    cowpi_disable_keypad_interrupts();
+#endif //ARDUINO_AVR_UNO || ARDUINO_AVR_NANO
+    // a scan that is already running must not see its state being reset
+    cowpi_disable_keypad_scanning();
+    stop_sampled_scans();
+    keypad_matrix_t matrix = scan_keypad();
+    reset_keypad_reports(matrix);
+    // the scan starts with row 0 on the first interrupt
+    keypad_row = 0;
+    partial_matrix = 0;
+    previous_matrix = matrix;
+    set_keypad_rows(0x1);
+    keypad_mode = KEYPAD_IS_SCANNED_IN_BACKGROUND;
+}
+
+#if defined (__AVR__)
+
+bool cowpi_enable_keypad_scanning(unsigned int timer_number, unsigned int isr_slot) {
+    start_keypad_scanning();
+    if (!register_periodic_ISR(timer_number, isr_slot, scan_next_keypad_row)) {
+        cowpi_disable_keypad_scanning();
+        return false;
+    }
+    return true;
+}
+
+#endif //__AVR__
+
+#ifdef __MBED__
+
+bool cowpi_enable_keypad_scanning(unsigned int timer_number, uint32_t period_us) {
+    start_keypad_scanning();
+    if (!register_periodic_ISR(timer_number, period_us, scan_next_keypad_row)) {
+        cowpi_disable_keypad_scanning();
+        return false;
+    }
+    return true;
+}
+
+#endif //__MBED__
+
+void cowpi_disable_keypad_scanning(void) {
+    if (keypad_mode == KEYPAD_IS_SCANNED_IN_BACKGROUND) {
+        set_keypad_rows(ALL_KEYPAD_ROWS);
+        keypad_mode = IDLE_KEYPAD_MODE;
+    }
+}
+
+
+/* Interrupt-driven scanning */
+
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+
+#define KEYPAD_DEBOUNCE_THRESHOLD (20L)
+
+#define COLUMN_PIN(pin) | (1L << (pin))
+static uint32_t const keypad_column_pins = 0 COWPI_KEYPAD_COLUMN_PINS(COLUMN_PIN);
+
+static keypad_matrix_t volatile candidate_matrix = 0;
+static unsigned long volatile candidate_time = 0;
+
+// must be called from an ISR or with interrupts disabled
+static void report_stable_candidate(unsigned long now) {
+    if (candidate_matrix != reported_matrix && now - candidate_time >= KEYPAD_DEBOUNCE_THRESHOLD) {
+        report_keypad_matrix(candidate_matrix);
+    }
+}
+
+/*
+ * Scanning toggles the columns, which sets their pin change interrupt's flag, but the flag is left set: clearing it
+ * would also discard a change on another pin in the same I/O bank. When the scan ends, the rows are all LOW again, so
+ * the dispatcher finds the columns unchanged from the values that it invoked this ISR for, unless a key changed.
+ */
+static void handle_keypad_column_change(void) {
+    unsigned long now = millis();
+    // if the previous change has been stable long enough then it wasn't a bounce
+    report_stable_candidate(now);
+    keypad_matrix_t matrix;
+    uint8_t attempts = 0;
+    do {
+        matrix = scan_keypad();
+        // if the keys changed while scanning, then scan again
+    } while (get_keypad_columns() != get_pressed_columns(matrix) && ++attempts < 4);
+    // every change restarts the debounce interval, even if it is a bounce back to the candidate
+    candidate_matrix = matrix;
+    candidate_time = now;
+}
+
+void cowpi_enable_keypad_interrupts(void) {
+    cowpi_disable_keypad_scanning();
+    stop_sampled_scans();
+    keypad_matrix_t matrix = scan_keypad();
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        reset_keypad_reports(matrix);
+        candidate_matrix = matrix;
+        candidate_time = millis() - KEYPAD_DEBOUNCE_THRESHOLD;
+    }
+    keypad_mode = KEYPAD_IS_INTERRUPT_DRIVEN;
+    cowpi_register_pin_ISR(keypad_column_pins, handle_keypad_column_change);
+}
+
+void cowpi_disable_keypad_interrupts(void) {
+    if (keypad_mode == KEYPAD_IS_INTERRUPT_DRIVEN) {
+        cowpi_deregister_pin_ISR(keypad_column_pins);
+        keypad_mode = IDLE_KEYPAD_MODE;
+    }
+}
+
+static void update_keypad_reports(void) {
+    if (keypad_mode == KEYPAD_IS_INTERRUPT_DRIVEN) {
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            report_stable_candidate(millis());
+        }
+    }
+}
+
+#else
+
+static inline void update_keypad_reports(void) {}
+
+#endif //ARDUINO_AVR_UNO || ARDUINO_AVR_NANO
+
+
+/* Polling */
+
+bool cowpi_get_keypad_event(cowpi_keypad_event_t *event) {
+    update_keypad_reports();
+    uint8_t tail = keypad_events_tail;
+    if (tail == keypad_events_head) {
+        return false;
+    }
+    event->key = keypad_events[tail].key;
+    event->pressed = keypad_events[tail].pressed;
+    keypad_events_tail = (tail + 1) & (COWPI_KEYPAD_EVENT_BUFFER_SIZE - 1);    // release the slot only after reading it
+    return true;
+}
+
+char cowpi_get_keypress(void) {
+    if (keypad_mode == KEYPAD_IS_POLLED) {
+        return decode_keypress(scan_keypad());
+    }
+    update_keypad_reports();
+    return reported_keypress;
+}
+
+uint16_t cowpi_get_keypresses(void) {
+    if (keypad_mode == KEYPAD_IS_POLLED) {
+        return decode_keypresses(scan_keypad());
+    }
+    update_keypad_reports();
+    return reported_keypresses;
+}
+
+
+
+/* Sampling with the other inputs */
+
+/*
+ * A polled scan in loop() could be interrupted by a scan in the sampling interrupt between driving a row LOW and
+ * reading the columns, leaving the rows in the wrong state for both scans. While the keypad is sampled, polling
+ * therefore examines the most recent sample instead of scanning the keypad. As with background scanning, a change is
+ * reported after it has been seen in two consecutive samples.
+ */
+
+void cowpi_enable_keypad_sampling(void) {
+    keypad_sampling_is_enabled = true;
+    if (keypad_mode == KEYPAD_IS_POLLED) {
+        keypad_matrix_t matrix = scan_keypad();
+        reset_keypad_reports(matrix);
+        previous_matrix = matrix;
+        keypad_mode = KEYPAD_IS_SAMPLED;
+    }
+}
+
+void cowpi_disable_keypad_sampling(void) {
+    keypad_sampling_is_enabled = false;
+    stop_sampled_scans();
+}
+
+uint16_t cowpi_sample_keypresses(void) {
+    if (keypad_mode == KEYPAD_IS_SAMPLED) {
+        keypad_matrix_t matrix = scan_keypad();
+        if (matrix == previous_matrix && matrix != reported_matrix) {
+            report_keypad_matrix(matrix);
+        }
+        previous_matrix = matrix;
+        // the input service debounces the keys itself
+        return decode_keypresses(matrix);
+    }
+    if (keypad_mode == KEYPAD_IS_POLLED) {
+        return 0;
+    }
+    update_keypad_reports();
+    return reported_keypresses;
+}
+
+uint16_t cowpi_get_unambiguous_keypresses(uint16_t *uncertain_keypresses) {
+    keypad_matrix_t matrix;
+    if (keypad_mode == KEYPAD_IS_POLLED) {
+        matrix = scan_keypad();
+    } else {
+        update_keypad_reports();
+        matrix = reported_matrix;
+    }
+    keypad_matrix_t ambiguous_keys = find_ambiguous_keys(matrix);
+    *uncertain_keypresses = decode_keypresses(ambiguous_keys);
+    return decode_keypresses(matrix & ~ambiguous_keys);
+}
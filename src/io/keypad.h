@@ -0,0 +1,236 @@
+/**************************************************************************//**
+ *
+ * @file keypad.h
+ *
+ * @author Christopher A. Bohn
+ *
+ * @brief Defines the functions to scan the keypad in the background or when
+ * interrupts indicate a change, and to obtain keypad events.
+ *
+ * The simple keypad functions, `cowpi_get_keypress()` and
+ * `cowpi_get_keypresses()`, are declared in cowpi_io.h.
+ *
+ * The keypad's geometry can be changed from the common 4x4 keypad by defining
+ * these macros when building the library:
+ * - `COWPI_KEYPAD_ROW_PINS(ROW)` lists the row pins, from top to bottom, each
+ *   wrapped in `ROW()`; for example, `ROW(4) ROW(5) ROW(6) ROW(7)`
+ * - `COWPI_KEYPAD_COLUMN_PINS(COLUMN)` lists the column pins, from left to
+ *   right, each wrapped in `COLUMN()`; for example,
+ *   `COLUMN(14) COLUMN(15) COLUMN(16)`
+ * - `COWPI_KEYPAD_LEGEND` is a string with the character depicted on each key,
+ *   row by row; for example, `"123456789*0#"`
+ *
+ * The keypad can have up to 8 rows, up to 8 columns, and up to 16 keys. Each
+ * key has its own bit in `cowpi_get_keypresses()`, so the legend's characters
+ * must be distinct, and each must be a digit, `A`-`D`, `#`, or `*`. A
+ * geometry or legend that breaks these rules is a compile-time error. The pins
+ * and legend are resolved at compile time, so any geometry is scanned with the
+ * same direct register access as the 4x4 keypad.
+ *
+ * These macros must be defined as build flags (for example, `-D` options in
+ * the board's `compiler.c.extra_flags`), because the library's source files
+ * are compiled separately from the sketch: a `#define` in the sketch is not
+ * seen by the library.
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COWPI_KEYPAD_H
+#define COWPI_KEYPAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Describes a key being pressed or released.
+ */
+typedef struct {
+    char key;                           //!< ASCII character depicted on the key (0-9, A-D, *, #)
+    bool pressed;                       //!< `true` if the key was pressed, `false` if the key was released
+} cowpi_keypad_event_t;
+
+#if defined (__AVR__)
+
+/**
+ * @brief Scans the keypad in the background, one row per timer interrupt.
+ *
+ * Each time the timer's interrupt fires, one row of the keypad is scanned;
+ * the entire keypad is scanned once every row has been scanned. A change is reported
+ * only after it has been seen in two consecutive scans of the entire keypad,
+ * which filters-out most switch bounce if the timer's period is at least 2ms.
+ * Each key press and each key release is placed in a buffer to be retrieved
+ * by `cowpi_get_keypad_event()`.
+ *
+ * While the keypad is being scanned in the background, `cowpi_get_keypress()`
+ * and `cowpi_get_keypresses()` report the result of the most recent
+ * background scan instead of scanning the keypad themselves.
+ *
+ * If the keypad is interrupt-driven, then it will no longer be
+ * interrupt-driven.
+ *
+ * The timer must have previously been configured using `configure_timer()`.
+ *
+ * @note Because the keypad's rows are driven LOW one at a time, a pin-based
+ *      interrupt on the keypad's columns will fire during the background scan.
+ *
+ * @sa register_periodic_ISR
+ *
+ * @param timer_number The timer whose interrupt will scan the keypad
+ * @param isr_slot The ISR slot to use to scan the keypad
+ * @return `true` if the background scan was successfully started;
+ *      `false` otherwise
+ */
+bool cowpi_enable_keypad_scanning(unsigned int timer_number, unsigned int isr_slot) __attribute__ ((warn_unused_result));
+
+#endif //__AVR__
+
+#ifdef __MBED__
+
+/**
+ * @brief Scans the keypad in the background, one row per timer interrupt.
+ *
+ * Each time the timer's interrupt fires, one row of the keypad is scanned;
+ * the entire keypad is scanned once every row has been scanned. A change is reported
+ * only after it has been seen in two consecutive scans of the entire keypad,
+ * which filters-out most switch bounce if the timer's period is at least 2ms.
+ * Each key press and each key release is placed in a buffer to be retrieved
+ * by `cowpi_get_keypad_event()`.
+ *
+ * While the keypad is being scanned in the background, `cowpi_get_keypress()`
+ * and `cowpi_get_keypresses()` report the result of the most recent
+ * background scan instead of scanning the keypad themselves.
+ *
+ * If the keypad is interrupt-driven, then it will no longer be
+ * interrupt-driven.
+ *
+ * Any ISR that had previously been registered for the timer will be
+ * deregistered.
+ *
+ * @note Because the keypad's rows are driven LOW one at a time, a pin-based
+ *      interrupt on the keypad's columns will fire during the background scan.
+ *
+ * @sa register_periodic_ISR
+ *
+ * @param timer_number A unique handle for the virtual periodic timer that will
+ *      scan the keypad
+ * @param period_us The time between scanning successive rows
+ * @return `true` if the background scan was successfully started;
+ *      `false` otherwise
+ */
+bool cowpi_enable_keypad_scanning(unsigned int timer_number, uint32_t period_us) __attribute__ ((warn_unused_result));
+
+#endif //__MBED__
+
+/**
+ * @brief Stops scanning the keypad in the background.
+ *
+ * The timer interrupt will continue to fire but will no longer scan the
+ * keypad. Any keypad events that have not yet been retrieved will remain
+ * available to `cowpi_get_keypad_event()`.
+ */
+void cowpi_disable_keypad_scanning(void);
+
+#if defined (ARDUINO_AVR_UNO) || defined (ARDUINO_AVR_NANO)
+
+/**
+ * @brief Scans the keypad only when a key is pressed or released.
+ *
+ * All of the keypad's rows are held LOW, and a pin-based interrupt is
+ * registered for the keypad's columns. The keypad is scanned only when a
+ * column changes; while no key is pressed or released, no time is spent
+ * scanning the keypad. A change is reported only after the keypad has been
+ * stable for 20ms, filtering-out switch bounce. Each key press and each key
+ * release is placed in a buffer to be retrieved by `cowpi_get_keypad_event()`.
+ *
+ * While the keypad is interrupt-driven, `cowpi_get_keypress()` and
+ * `cowpi_get_keypresses()` report the most recent stable scan instead of
+ * scanning the keypad themselves.
+ *
+ * If the keypad is being scanned in the background, then background scanning
+ * will stop.
+ *
+ * @note Pressing a second key in a column whose key is already pressed does not
+ *      change that column, and so will not be detected until some other change
+ *      causes the keypad to be scanned. The same is true of releasing one of
+ *      two keys pressed in the same column.
+ *
+ * @sa cowpi_register_pin_ISR
+ */
+void cowpi_enable_keypad_interrupts(void);
+
+/**
+ * @brief Stops scanning the keypad when a key is pressed or released.
+ *
+ * The pin-based interrupt for the keypad's columns is deregistered. Any keypad
+ * events that have not yet been retrieved will remain available to
+ * `cowpi_get_keypad_event()`.
+ */
+void cowpi_disable_keypad_interrupts(void);
+
+#endif //ARDUINO_AVR_UNO || ARDUINO_AVR_NANO
+
+/**
+ * @brief Retrieves the oldest keypad event that has not yet been retrieved.
+ *
+ * Up to `COWPI_KEYPAD_EVENT_BUFFER_SIZE - 1` events are buffered; if the
+ * buffer is full, newer events are discarded until older events are
+ * retrieved. This function does not wait for an event.
+ *
+ * @param event Pointer to the structure that will receive the event
+ * @return `true` if an event was retrieved; `false` if there was no event
+ */
+bool cowpi_get_keypad_event(cowpi_keypad_event_t *event);
+
+/**
+ * @brief Scans the keypad to determine which keys have been pressed, reporting
+ * separately the keys that might be phantom keypresses.
+ *
+ * Without diodes to isolate the keys, pressing three keys at the corners of a
+ * rectangle will cause the key at the fourth corner to appear to be pressed.
+ * When the keys that appear to be pressed include any rectangle, there is no
+ * way to determine which of those keys are actually pressed and which are
+ * phantoms. This function reports every key that is certainly pressed and,
+ * separately, every key that appears to be pressed but might be a phantom.
+ *
+ * The bit vectors use the same bit positions as `cowpi_get_keypresses()`. The
+ * time to examine the scanned keypad does not depend on which keys are pressed.
+ *
+ * If the keypad is being scanned in the background, is interrupt-driven, or is
+ * sampled with the other inputs (see `cowpi_enable_input_sampling()`), then
+ * the most recent scan is examined instead of scanning the keypad.
+ *
+ * @note If diodes are used to isolate the keys, as on the Cow Pi mark 3 and
+ *      mark 4 development boards, then there are no phantom keypresses, and
+ *      `cowpi_get_keypresses()` should be used instead.
+ *
+ * @sa cowpi_get_keypresses
+ *
+ * @param uncertain_keypresses Pointer to the bit vector that will receive the
+ *      keys that appear to be pressed but might not be
+ * @return bit vector that indicates which keys are certainly pressed
+ */
+uint16_t cowpi_get_unambiguous_keypresses(uint16_t *uncertain_keypresses);
+
+#define COWPI_KEYPAD_EVENT_BUFFER_SIZE (16)    //!< Capacity of the keypad event buffer, plus one; must be a power of two
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif //COWPI_KEYPAD_H
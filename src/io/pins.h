@@ -0,0 +1,218 @@
+/**************************************************************************//**
+ *
+ * @file pins.h
+ *
+ * @author Christopher A. Bohn
+ *
+ * @brief Defines single-instruction access to individual pins whose numbers
+ * are known at compile time.
+ *
+ * In C, the `cowpi_set_pin_high()`, `cowpi_set_pin_low()`,
+ * `cowpi_toggle_pin()`, and `cowpi_pin_is_high()` functions are always
+ * inlined; when the pin number is a compile-time constant, the port and bit
+ * are resolved by the compiler. In C++, the `cowpi::Pin` template provides the
+ * same access with the pin number as a template argument, for example,
+ * `cowpi::Pin<13>::set_high()`.
+ *
+ * On the ATmega328P, each operation compiles to a single `sbi`, `cbi`, or
+ * `out` instruction, or to an `sbis`/`sbic` test. The same is true on the
+ * ATmega2560 for ports A-G; ports H-L are outside the range of `sbi` and
+ * `cbi`, and so setting or clearing one of their pins is a load, a bitwise
+ * operation, and a store, with interrupts disabled. On the Raspberry Pi Pico,
+ * whose pin numbers are its RP2040's GPIO numbers, each operation compiles to a
+ * single store to the SIO's `atomic_set`, `atomic_clear`, or `atomic_toggle`
+ * register, or to a single load from its `input` register. On other boards,
+ * including other RP2040 boards, this is a portable implementation.
+ *
+ * The pin must already be configured as an input or output pin, such as by
+ * `cowpi_setup()`.
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COWPI_PINS_H
+#define COWPI_PINS_H
+
+#include <Arduino.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../boards/boards.h"
+#if defined (__AVR_ATmega2560__)
+#include <util/atomic.h>
+#endif //__AVR_ATmega2560__
+
+// the Pico form factor, tested as cowpi_internal.h does, since only the Pico's Arduino pin numbers are its GPIO numbers
+#if (defined (ARDUINO_RASPBERRY_PI_PICO) || defined (PICO_RP2040)) && defined (ARDUINO_ARCH_RP2040)
+#define COWPI_PINS_ARE_GPIOS
+#endif //COWPI_PINS_ARE_GPIOS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined (__AVR_ATmega328P__)
+
+static inline __attribute__ ((always_inline)) void cowpi_set_pin_high(uint8_t pin) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    ioports[COWPI_PIN_PORT(pin)].output |= COWPI_PIN_MASK(pin);
+}
+
+static inline __attribute__ ((always_inline)) void cowpi_set_pin_low(uint8_t pin) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    ioports[COWPI_PIN_PORT(pin)].output &= ~COWPI_PIN_MASK(pin);
+}
+
+static inline __attribute__ ((always_inline)) void cowpi_toggle_pin(uint8_t pin) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    // writing a 1 to a PINx bit toggles the corresponding PORTx bit
+    ioports[COWPI_PIN_PORT(pin)].input = COWPI_PIN_MASK(pin);
+}
+
+static inline __attribute__ ((always_inline)) bool cowpi_pin_is_high(uint8_t pin) {
+    cowpi_ioport_t volatile *ioports = (cowpi_ioport_t *) (COWPI_IO_BASE + 0x3);
+    return (ioports[COWPI_PIN_PORT(pin)].input & COWPI_PIN_MASK(pin)) != 0;
+}
+
+#elif defined (__AVR_ATmega2560__)
+
+static inline __attribute__ ((always_inline)) void cowpi_set_pin_high(uint8_t pin) {
+    if (COWPI_PIN_PORT(pin) < COWPI_PH) {
+        COWPI_IOPORT(COWPI_PIN_PORT(pin))->output |= COWPI_PIN_MASK(pin);
+    } else {
+        // ports H-L need a read-modify-write that an ISR could interrupt
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            COWPI_IOPORT(COWPI_PIN_PORT(pin))->output |= COWPI_PIN_MASK(pin);
+        }
+    }
+}
+
+static inline __attribute__ ((always_inline)) void cowpi_set_pin_low(uint8_t pin) {
+    if (COWPI_PIN_PORT(pin) < COWPI_PH) {
+        COWPI_IOPORT(COWPI_PIN_PORT(pin))->output &= ~COWPI_PIN_MASK(pin);
+    } else {
+        // ports H-L need a read-modify-write that an ISR could interrupt
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            COWPI_IOPORT(COWPI_PIN_PORT(pin))->output &= ~COWPI_PIN_MASK(pin);
+        }
+    }
+}
+
+static inline __attribute__ ((always_inline)) void cowpi_toggle_pin(uint8_t pin) {
+    // writing a 1 to a PINx bit toggles the corresponding PORTx bit
+    COWPI_IOPORT(COWPI_PIN_PORT(pin))->input = COWPI_PIN_MASK(pin);
+}
+
+static inline __attribute__ ((always_inline)) bool cowpi_pin_is_high(uint8_t pin) {
+    return (COWPI_IOPORT(COWPI_PIN_PORT(pin))->input & COWPI_PIN_MASK(pin)) != 0;
+}
+
+#elif defined (COWPI_PINS_ARE_GPIOS)
+
+static inline __attribute__ ((always_inline)) void cowpi_set_pin_high(uint8_t pin) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    ioport->atomic_set = 1uL << pin;
+}
+
+static inline __attribute__ ((always_inline)) void cowpi_set_pin_low(uint8_t pin) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    ioport->atomic_clear = 1uL << pin;
+}
+
+static inline __attribute__ ((always_inline)) void cowpi_toggle_pin(uint8_t pin) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    ioport->atomic_toggle = 1uL << pin;
+}
+
+static inline __attribute__ ((always_inline)) bool cowpi_pin_is_high(uint8_t pin) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    return (ioport->input & (1uL << pin)) != 0;
+}
+
+#else
+
+static inline void cowpi_set_pin_high(uint8_t pin) {
+    digitalWrite(pin, HIGH);
+}
+
+static inline void cowpi_set_pin_low(uint8_t pin) {
+    digitalWrite(pin, LOW);
+}
+
+static inline void cowpi_toggle_pin(uint8_t pin) {
+    digitalWrite(pin, !digitalRead(pin));
+}
+
+static inline bool cowpi_pin_is_high(uint8_t pin) {
+    return digitalRead(pin);
+}
+
+#endif //MICROCONTROLLER
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#ifdef __cplusplus
+
+namespace cowpi {
+
+/**
+ * @brief A pin whose number is known at compile time.
+ *
+ * For example, on an Arduino Uno or Nano, `cowpi::Pin<13>::set_high()`
+ * illuminates the left LED, and `cowpi::Pin<8>::is_high()` is `false` while the
+ * left button is pressed.
+ *
+ * @tparam PIN the pin's number
+ */
+template <uint8_t PIN>
+struct Pin {
+#if defined (__AVR_ATmega328P__)
+    static_assert(PIN < 20, "The ATmega328P has only pins 0-19");
+#elif defined (__AVR_ATmega2560__)
+    static_assert(PIN < 70, "The Arduino Mega 2560 has only pins 0-69");
+#elif defined (COWPI_PINS_ARE_GPIOS)
+    static_assert(PIN < 30, "The RP2040 has only GPIO pins 0-29");
+#endif //MICROCONTROLLER
+
+    static constexpr uint8_t number = PIN;  //!< The pin's number
+
+    /** @brief Drives the pin HIGH. */
+    static inline __attribute__ ((always_inline)) void set_high() { cowpi_set_pin_high(PIN); }
+
+    /** @brief Drives the pin LOW. */
+    static inline __attribute__ ((always_inline)) void set_low() { cowpi_set_pin_low(PIN); }
+
+    /** @brief Drives the pin HIGH if `value` is `true`, or LOW otherwise. */
+    static inline __attribute__ ((always_inline)) void write(bool value) {
+        if (value) {
+            cowpi_set_pin_high(PIN);
+        } else {
+            cowpi_set_pin_low(PIN);
+        }
+    }
+
+    /** @brief Drives the pin to the opposite of its current output. */
+    static inline __attribute__ ((always_inline)) void toggle() { cowpi_toggle_pin(PIN); }
+
+    /** @brief Reports whether the pin is HIGH. */
+    static inline __attribute__ ((always_inline)) bool is_high() { return cowpi_pin_is_high(PIN); }
+};
+
+} // namespace cowpi
+
+#endif //__cplusplus
+
+#endif //COWPI_PINS_H
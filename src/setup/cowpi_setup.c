@@ -24,6 +24,7 @@
 #include <Arduino.h>
 #include <CowPi_stdio.h>
 #include "../internal/cowpi_internal.h"
+#include "../boards/boards.h"
 #include "cowpi_setup.h"
 
 
@@ -59,30 +60,41 @@ FILE *cowpi_setup(unsigned long console_bitrate,
         cowpi_right_switch = RIGHT_SWITCH_I2C;
         cowpi_data_pin = DATA_I2C;
         cowpi_clock_pin = CLOCK_I2C;
-    } else {}
+    } else {
+        cowpi_left_switch = UNASSIGNED_PIN;
+        cowpi_right_switch = UNASSIGNED_PIN;
+    }
     /* unused pins on UnoNano and Mega form factors */
-    cowpi_set_floating_input_pins((1 << 2) | (1 << 3));
+    cowpi_set_floating_input_pins(COWPI_PIN_SET(2) | COWPI_PIN_SET(3));
     /* LEDs */
-    cowpi_set_output_pins((1 << LEFT_LED) | (1 << RIGHT_LED) | (1 << INTERNAL_LED));
+    cowpi_set_output_pins(COWPI_PIN_SET(LEFT_LED) | COWPI_PIN_SET(RIGHT_LED) | COWPI_PIN_SET(INTERNAL_LED));
     /* switches and buttons */
-    cowpi_set_pullup_input_pins((1 << LEFT_BUTTON) | (1 << RIGHT_BUTTON));
+    cowpi_set_pullup_input_pins(COWPI_PIN_SET(LEFT_BUTTON) | COWPI_PIN_SET(RIGHT_BUTTON));
     if (cowpi_protocol != NO_PROTOCOL) {
-        cowpi_set_pullup_input_pins((1 << cowpi_left_switch) | (1 << cowpi_right_switch));
+        cowpi_set_pullup_input_pins(COWPI_PIN_SET(cowpi_left_switch) | COWPI_PIN_SET(cowpi_right_switch));
     } else {
         // we don't know which pins are used for the switches, so we'll prep both possibilities
-        cowpi_set_pullup_input_pins((1 << LEFT_SWITCH_SPI) | (1 << LEFT_SWITCH_I2C) | (1 << RIGHT_SWITCH_SPI) | (1 << RIGHT_SWITCH_I2C));
+        cowpi_set_pullup_input_pins(COWPI_PIN_SET(LEFT_SWITCH_SPI) | COWPI_PIN_SET(LEFT_SWITCH_I2C)
+                                    | COWPI_PIN_SET(RIGHT_SWITCH_SPI) | COWPI_PIN_SET(RIGHT_SWITCH_I2C));
+#ifdef COWPI_DETECT_SWITCHES_AT_SETUP
+        // and then try to find out
+        delayMicroseconds(10);      // give the pullups time to charge the unconnected pins
+        cowpi_detect_switches();
+#endif //COWPI_DETECT_SWITCHES_AT_SETUP
     }
     /* keypad */
-    cowpi_set_output_pins((1 << KEYPAD_ROW_1) | (1 << KEYPAD_ROW_4) | (1 << KEYPAD_ROW_7) | (1 << KEYPAD_ROW_STAR));
-    cowpi_set_pullup_input_pins((1 << KEYPAD_COLUMN_1) | (1 << KEYPAD_COLUMN_2) | (1 << KEYPAD_COLUMN_3) | (1 << KEYPAD_COLUMN_A));
+#define KEYPAD_PIN(pin) | COWPI_PIN_SET(pin)
+    cowpi_set_output_pins(0 COWPI_KEYPAD_ROW_PINS(KEYPAD_PIN));
+    cowpi_set_pullup_input_pins(0 COWPI_KEYPAD_COLUMN_PINS(KEYPAD_PIN));
+#undef KEYPAD_PIN
     /* display module */
     if (cowpi_protocol == COWPI_SPI) {
-        cowpi_set_output_pins((1 << cowpi_data_pin) | (1 << cowpi_clock_pin) | (1 << cowpi_latch_pin));
+        cowpi_set_output_pins(COWPI_PIN_SET(cowpi_data_pin) | COWPI_PIN_SET(cowpi_clock_pin) | COWPI_PIN_SET(cowpi_latch_pin));
         digitalWrite(cowpi_data_pin, LOW);
         digitalWrite(cowpi_clock_pin, LOW);
         digitalWrite(cowpi_latch_pin, HIGH);
     } else if (cowpi_protocol == COWPI_I2C) {
-        cowpi_set_floating_input_pins((1 << cowpi_data_pin) | (1 << cowpi_clock_pin));
+        cowpi_set_floating_input_pins(COWPI_PIN_SET(cowpi_data_pin) | COWPI_PIN_SET(cowpi_clock_pin));
     } else {}
     if (display_module.display_module == NO_MODULE) {
         return NULL;
@@ -96,12 +108,117 @@ FILE *cowpi_setup(unsigned long console_bitrate,
 }
 
 
-uint32_t cowpi_output_pins = 0;
-uint32_t cowpi_floating_input_pins = 0;
-uint32_t cowpi_pullup_input_pins = 0;
-uint32_t cowpi_pulldown_input_pins = 0;
+// if only one of a switch's possible pins is 0, then (a) that must be where the switch is, and (b) it's to the left
+static uint8_t detect_switch(uint8_t spi_pin, uint8_t i2c_pin) {
+    if (spi_pin == i2c_pin) {
+        return spi_pin;
+    }
+    bool spi_pin_is_low = !digitalRead(spi_pin);
+    bool i2c_pin_is_low = !digitalRead(i2c_pin);
+    if (spi_pin_is_low == i2c_pin_is_low) {
+        return UNASSIGNED_PIN;
+    }
+    return spi_pin_is_low ? spi_pin : i2c_pin;
+}
+
+bool cowpi_detect_switches(void) {
+    if (cowpi_left_switch == UNASSIGNED_PIN) {
+        cowpi_left_switch = detect_switch(LEFT_SWITCH_SPI, LEFT_SWITCH_I2C);
+    }
+    if (cowpi_right_switch == UNASSIGNED_PIN) {
+        cowpi_right_switch = detect_switch(RIGHT_SWITCH_SPI, RIGHT_SWITCH_I2C);
+    }
+    return cowpi_left_switch != UNASSIGNED_PIN && cowpi_right_switch != UNASSIGNED_PIN;
+}
+
+
+cowpi_pin_set_t cowpi_output_pins = 0;
+cowpi_pin_set_t cowpi_floating_input_pins = 0;
+cowpi_pin_set_t cowpi_pullup_input_pins = 0;
+cowpi_pin_set_t cowpi_pulldown_input_pins = 0;
+
+#if defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040) && !defined (__MBED__)
+
+#define PAD_OUTPUT_DISABLE  (1 << 7)
+#define PAD_INPUT_ENABLE    (1 << 6)
+#define PAD_PULLUP          (1 << 3)
+#define PAD_PULLDOWN        (1 << 2)
+#define FUNCTION_SIO        (5)
 
-void cowpi_set_output_pins(uint32_t pins) {
+/*
+ * Only the Raspberry Pi Pico's Arduino pin numbers are its GPIO numbers, and only the arduino-pico core reads the pins
+ * through the registers; the MBED core's pin objects must be configured through cowpi_pin_mode().
+ *
+ * Each pin has its own pad and function-select registers, but the pins' directions are all in one SIO register. The
+ * directions are set with one store, and only the pins being configured have their pad and function-select registers
+ * written: three stores per pin, using the pads' atomic set/clear aliases to avoid read-modify-write sequences.
+ */
+static void configure_pins(uint32_t pins, bool output, uint32_t pad_bits_to_set, uint32_t pad_bits_to_clear) {
+    cowpi_ioport_t volatile *ioport = (cowpi_ioport_t *) (COWPI_IO_BASE);
+    cowpi_iobank_t volatile *iobank = (cowpi_iobank_t *) (0x40014000);
+    cowpi_pads_t volatile *pads_set = (cowpi_pads_t *) (0x4001C000 + COWPI_ATOMIC_SET_OFFSET);
+    cowpi_pads_t volatile *pads_clear = (cowpi_pads_t *) (0x4001C000 + COWPI_ATOMIC_CLEAR_OFFSET);
+    pins &= 0x3FFFFFFF;                 // GPIO0-GPIO29
+    // as with pinMode(), an output pin starts LOW, and a pin is not driven until it is connected to the SIO
+    if (output) {
+        ioport->atomic_clear = pins;
+    } else {
+        ioport->atomic_clear_enable = pins;
+    }
+    for (uint32_t remaining_pins = pins; remaining_pins; remaining_pins &= remaining_pins - 1) {
+        unsigned int pin = __builtin_ctzl(remaining_pins);
+        pads_set->gpio[pin] = pad_bits_to_set;
+        pads_clear->gpio[pin] = pad_bits_to_clear;
+        iobank[pin].control = FUNCTION_SIO;
+    }
+    if (output) {
+        ioport->atomic_set_enable = pins;
+    }
+}
+
+#elif defined (__AVR_ATmega2560__)
+
+/*
+ * The Arduino Mega 2560's pin numbers don't follow the order of the I/O ports' bits, so the pins are first sorted into
+ * one mask per port; then each port that has a pin being configured is updated once.
+ */
+static void configure_ports(cowpi_pin_set_t pins, bool output, bool pullup) {
+    uint8_t port_masks[COWPI_NUMBER_OF_PORTS] = {0};
+    while (pins) {
+        uint8_t pin = __builtin_ctzll(pins);
+        port_masks[COWPI_PIN_PORT(pin)] |= COWPI_PIN_MASK(pin);
+        pins &= pins - 1;               // clear the lowest 1 bit
+    }
+    for (uint8_t port = 0; port < COWPI_NUMBER_OF_PORTS; port++) {
+        uint8_t mask = port_masks[port];
+        if (mask) {
+            cowpi_ioport_t volatile *ioport = COWPI_IOPORT(port);
+            if (output) {
+                ioport->direction |= mask;
+            } else {
+                ioport->direction &= ~mask;
+                if (pullup) {
+                    ioport->output |= mask;
+                } else {
+                    ioport->output &= ~mask;
+                }
+            }
+        }
+    }
+}
+
+#elif !defined (__AVR_ATmega328P__)
+
+static void set_pin_modes(cowpi_pin_set_t pins, pin_mode_t mode) {
+    while (pins) {
+        cowpi_pin_mode(__builtin_ctzll(pins), mode);
+        pins &= pins - 1;               // clear the lowest 1 bit
+    }
+}
+
+#endif //MICROCONTROLLER
+
+void cowpi_set_output_pins(cowpi_pin_set_t pins) {
 #if defined (__AVR_ATmega328P__)
     uint8_t ddr_mask;
     ddr_mask = pins & 0xFF;
@@ -110,16 +227,12 @@ void cowpi_set_output_pins(uint32_t pins) {
     DDRB |= ddr_mask;   // pins 8-13
     ddr_mask = (pins >> 14) & 0x3F;
     DDRC |= ddr_mask;   // pins 14-19
-//#elif defined (ARDUINO_ARCH_RP2040)
-    // It looks like RP2040 has a separate register for each pad, so there's no
-    // conciseness benefit to directly manipulating the GPIO registers.
+#elif defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040) && !defined (__MBED__)
+    configure_pins(pins, true, PAD_INPUT_ENABLE, PAD_OUTPUT_DISABLE);
+#elif defined (__AVR_ATmega2560__)
+    configure_ports(pins, true, false);
 #else
-    for (int i = 0; i < 32; i++) {
-        if (pins & (1 << i)) {
-//            pinMode(i, OUTPUT);
-            cowpi_pin_mode(i, OUTPUT);
-        }
-    }
+    set_pin_modes(pins, OUTPUT);
 #endif
     cowpi_output_pins |= pins;
     cowpi_floating_input_pins &= ~pins;
@@ -127,7 +240,7 @@ void cowpi_set_output_pins(uint32_t pins) {
     cowpi_pulldown_input_pins &= ~pins;
 }
 
-void cowpi_set_floating_input_pins(uint32_t pins) {
+void cowpi_set_floating_input_pins(cowpi_pin_set_t pins) {
 #if defined (__AVR_ATmega328P__)
     uint8_t ddr_mask;
     ddr_mask = pins & 0xFF;
@@ -139,13 +252,12 @@ void cowpi_set_floating_input_pins(uint32_t pins) {
     ddr_mask = (pins >> 14) & 0x3F;
     DDRC &= ~ddr_mask;  // pins 14-19
     PORTC &= ~ddr_mask;
+#elif defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040) && !defined (__MBED__)
+    configure_pins(pins, false, PAD_INPUT_ENABLE, PAD_OUTPUT_DISABLE | PAD_PULLUP | PAD_PULLDOWN);
+#elif defined (__AVR_ATmega2560__)
+    configure_ports(pins, false, false);
 #else
-    for (int i = 0; i < 32; i++) {
-        if (pins & (1 << i)) {
-//            pinMode(i, INPUT);
-            cowpi_pin_mode(i, INPUT);
-        }
-    }
+    set_pin_modes(pins, INPUT);
 #endif
     cowpi_output_pins &= ~pins;
     cowpi_floating_input_pins |= pins;
@@ -153,7 +265,7 @@ void cowpi_set_floating_input_pins(uint32_t pins) {
     cowpi_pulldown_input_pins &= ~pins;
 }
 
-void cowpi_set_pullup_input_pins(uint32_t pins) {
+void cowpi_set_pullup_input_pins(cowpi_pin_set_t pins) {
 #if defined (__AVR_ATmega328P__)
     uint8_t ddr_mask;
     ddr_mask = pins & 0xFF;
@@ -165,13 +277,12 @@ void cowpi_set_pullup_input_pins(uint32_t pins) {
     ddr_mask = (pins >> 14) & 0x3F;
     DDRC &= ~ddr_mask;  // pins 14-19
     PORTC |= ddr_mask;
+#elif defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040) && !defined (__MBED__)
+    configure_pins(pins, false, PAD_INPUT_ENABLE | PAD_PULLUP, PAD_OUTPUT_DISABLE | PAD_PULLDOWN);
+#elif defined (__AVR_ATmega2560__)
+    configure_ports(pins, false, true);
 #else
-    for (int i = 0; i < 32; i++) {
-        if (pins & (1 << i)) {
-//            pinMode(i, INPUT_PULLUP);
-            cowpi_pin_mode(i, INPUT_PULLUP);
-        }
-    }
+    set_pin_modes(pins, INPUT_PULLUP);
 #endif
     cowpi_output_pins &= ~pins;
     cowpi_floating_input_pins &= ~pins;
@@ -180,25 +291,11 @@ void cowpi_set_pullup_input_pins(uint32_t pins) {
 }
 
 #ifdef ARDUINO_ARCH_RP2040
-void cowpi_set_pulldown_input_pins(uint32_t pins) {
-#if defined (__AVR_ATmega328P__)
-    uint8_t ddr_mask;
-    ddr_mask = pins & 0xFF;
-    DDRD &= ~ddr_mask;  // pins 0-7
-    PORTD |= ddr_mask;
-    ddr_mask = (pins >> 8) & 0x3F;
-    DDRB &= ~ddr_mask;  // pins 8-13
-    PORTB |= ddr_mask;
-    ddr_mask = (pins >> 14) & 0x3F;
-    DDRC &= ~ddr_mask;  // pins 14-19
-    PORTC |= ddr_mask;
+void cowpi_set_pulldown_input_pins(cowpi_pin_set_t pins) {
+#if defined (COWPI_PICO_FORMFACTOR) && defined (ARDUINO_ARCH_RP2040) && !defined (__MBED__)
+    configure_pins(pins, false, PAD_INPUT_ENABLE | PAD_PULLDOWN, PAD_OUTPUT_DISABLE | PAD_PULLUP);
 #else
-    for (int i = 0; i < 32; i++) {
-        if (pins & (1 << i)) {
-//            pinMode(i, INPUT_PULLDOWN);
-            cowpi_pin_mode(i, INPUT_PULLDOWN);
-        }
-    }
+    set_pin_modes(pins, INPUT_PULLDOWN);
 #endif
     cowpi_output_pins &= ~pins;
     cowpi_floating_input_pins &= ~pins;
@@ -24,8 +24,10 @@
 #ifndef COWPI_SETUP_H
 #define COWPI_SETUP_H
 
+#include <CowPi_stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "pin_set.h"
 
 /* Public-facing function prototypes */
 
@@ -48,6 +50,14 @@ extern "C" {
  * display module (and the communication protocol's pins are not otherwise used)
  * then you may assign `communication_protocol` to `{.protocol = NO_PROTOCOL}`.
  *
+ * If the communication protocol is `NO_PROTOCOL`, then each read of a switch
+ * reads both of the switch's possible pins, unless the switches' pins have
+ * been detected with `cowpi_detect_switches()`. If the library is built with
+ * `COWPI_DETECT_SWITCHES_AT_SETUP` defined (a build flag, such as
+ * `-DCOWPI_DETECT_SWITCHES_AT_SETUP` in `compiler.c.extra_flags`; a `#define`
+ * in the sketch is not seen by the library), then `cowpi_setup()` calls
+ * `cowpi_detect_switches()` itself.
+ *
  * @sa `cowpi_stdio_setup()` in CowPi_stdio
  * @sa `cowpi_add_display_module()` in CowPi_stdio
  *
@@ -62,21 +72,44 @@ FILE *cowpi_setup(unsigned long console_bitrate,
                   cowpi_display_module_t display_module,
                   cowpi_display_module_protocol_t communication_protocol);
 
+/**
+ * @brief Determines which pin each slide switch is connected to, so that
+ * reading a switch requires reading only one pin.
+ *
+ * Without a communication protocol, the library does not know whether the
+ * switches are wired for SPI or for I2C, and so each read of a switch must read
+ * both of the switch's possible pins. A switch in the left position grounds its
+ * pin, so if exactly one of a switch's possible pins is 0, then that pin is
+ * cached in the library's configuration and later reads use only that pin. A
+ * switch that is in the right position cannot be detected; its reads continue
+ * to use both possible pins until a later call detects it.
+ *
+ * A program that uses `NO_PROTOCOL` opts in by calling this function, such as
+ * after asking the user to slide both switches to the left, and can call it
+ * again later to detect a switch that was in the right position. If the
+ * library is built with `COWPI_DETECT_SWITCHES_AT_SETUP` defined, then
+ * `cowpi_setup()` also calls this function when the communication protocol is
+ * `NO_PROTOCOL`.
+ *
+ * @return `true` if the pins for both switches are known; `false` otherwise
+ */
+bool cowpi_detect_switches(void);
+
 /**
  * @brief Configures the specified pin to be output pins
  *
  * The <code>pins</code> argument is used to specify which pins will be output
- * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on. A 1 in
- * a particular bit indicates that the corresponding pin should be an output
- * pin, overriding any previous configuration for that pin. If more than one bit
- * has a 1, then each of the corresponding pins will be output pins. The
- * configuration of any pin whose corresponding bit bit is 0 will be unchanged,
- * regardless of whether that pin had been previously set as an input or output
- * pin.
+ * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on (see
+ * `COWPI_PIN_SET()`). A 1 in a particular bit indicates that the corresponding
+ * pin should be an output pin, overriding any previous configuration for that
+ * pin. If more than one bit has a 1, then each of the corresponding pins will
+ * be output pins. The configuration of any pin whose corresponding bit bit is 0
+ * will be unchanged, regardless of whether that pin had been previously set as
+ * an input or output pin.
  *
  * @param pins A bit vector specifying which pins will be output pins
  */
-void cowpi_set_output_pins(uint32_t pins);
+void cowpi_set_output_pins(cowpi_pin_set_t pins);
 
 /**
  * @brief Configures the specified pin to be input pins with high impedance to
@@ -84,18 +117,18 @@ void cowpi_set_output_pins(uint32_t pins);
  * values will float unless driven high or low by a peripheral device.
  *
  * The <code>pins</code> argument is used to specify which pins will be input
- * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on. A 1 in
- * a particular bit indicates that the corresponding pin should be a floating
- * input pin, overriding any previous configuration for that pin. If more than
- * one bit has a 1, then each of the corresponding pins will be floating input
- * pins. The configuration of any pin whose corresponding bit bit is 0 will be
- * unchanged, regardless of whether that pin had been previously set as an input
- * or output pin, and regardless of whether it had been previously set to float
- * or tied to a pullup or pulldown resistor.
+ * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on (see
+ * `COWPI_PIN_SET()`). A 1 in a particular bit indicates that the corresponding
+ * pin should be a floating input pin, overriding any previous configuration for
+ * that pin. If more than one bit has a 1, then each of the corresponding pins
+ * will be floating input pins. The configuration of any pin whose corresponding
+ * bit bit is 0 will be unchanged, regardless of whether that pin had been
+ * previously set as an input or output pin, and regardless of whether it had
+ * been previously set to float or tied to a pullup or pulldown resistor.
  *
  * @param pins A bit vector specifying which pins will be floating input pins
  */
-void cowpi_set_floating_input_pins(uint32_t pins);
+void cowpi_set_floating_input_pins(cowpi_pin_set_t pins);
 
 /**
  * @brief Configures the specified pin to be input pins connected to a pullup
@@ -103,18 +136,18 @@ void cowpi_set_floating_input_pins(uint32_t pins);
  * values will be high unless driven low by a peripheral device.
  *
  * The <code>pins</code> argument is used to specify which pins will be input
- * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on. A 1 in
- * a particular bit indicates that the corresponding pin should be a pulled-up
- * input pin, overriding any previous configuration for that pin. If more than
- * one bit has a 1, then each of the corresponding pins will be pulled-up input
- * pins. The configuration of any pin whose corresponding bit bit is 0 will be
- * unchanged, regardless of whether that pin had been previously set as an input
- * or output pin, and regardless of whether it had been previously set to float
- * or tied to a pullup or pulldown resistor.
+ * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on (see
+ * `COWPI_PIN_SET()`). A 1 in a particular bit indicates that the corresponding
+ * pin should be a pulled-up input pin, overriding any previous configuration
+ * for that pin. If more than one bit has a 1, then each of the corresponding
+ * pins will be pulled-up input pins. The configuration of any pin whose
+ * corresponding bit bit is 0 will be unchanged, regardless of whether that pin
+ * had been previously set as an input or output pin, and regardless of whether
+ * it had been previously set to float or tied to a pullup or pulldown resistor.
  *
  * @param pins A bit vector specifying which pins will be floating input pins
  */
-void cowpi_set_pullup_input_pins(uint32_t pins);
+void cowpi_set_pullup_input_pins(cowpi_pin_set_t pins);
 
 #ifdef ARDUINO_ARCH_RP2040
 /**
@@ -123,18 +156,18 @@ void cowpi_set_pullup_input_pins(uint32_t pins);
  * values will be low unless driven high by a peripheral device.
  *
  * The <code>pins</code> argument is used to specify which pins will be input
- * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on. A 1 in
- * a particular bit indicates that the corresponding pin should be a pulled-down
- * input pin, overriding any previous configuration for that pin. If more than
- * one bit has a 1, then each of the corresponding pins will be pulled-down
- * input pins. The configuration of any pin whose corresponding bit bit is 0
- * will be unchanged, regardless of whether that pin had been previously set as
- * an input or output pin, and regardless of whether it had been previously set
- * to float or tied to a pullup or pulldown resistor.
+ * pins. Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on (see
+ * `COWPI_PIN_SET()`). A 1 in a particular bit indicates that the corresponding
+ * pin should be a pulled-down input pin, overriding any previous configuration
+ * for that pin. If more than one bit has a 1, then each of the corresponding
+ * pins will be pulled-down input pins. The configuration of any pin whose
+ * corresponding bit bit is 0 will be unchanged, regardless of whether that pin
+ * had been previously set as an input or output pin, and regardless of whether
+ * it had been previously set to float or tied to a pullup or pulldown resistor.
  *
  * @param pins A bit vector specifying which pins will be floating input pins
  */
-void cowpi_set_pulldown_input_pins(uint32_t pins);
+void cowpi_set_pulldown_input_pins(cowpi_pin_set_t pins);
 #endif //ARDUINO_ARCH_RP2040
 
 #ifdef __cplusplus
@@ -0,0 +1,79 @@
+/**************************************************************************//**
+ *
+ * @file pin_set.h
+ *
+ * @author Christopher A. Bohn
+ *
+ * @brief Defines the bit vector type used to specify a set of pins.
+ *
+ * Bit0 corresponds to Pin 0, Bit1 corresponds to Pin 1, and so on. The type
+ * is wide enough for every pin on the microcontroller board: 64 bits on the
+ * Arduino Mega 2560 (whose pins are numbered up to 69), and 32 bits otherwise.
+ *
+ * Pin sets should be built with `COWPI_PIN_SET()` (or, in C++,
+ * `cowpi::pin_set()`) instead of `1 << pin`, which overflows for pins above
+ * 15 on AVR microcontrollers and for pins above 31 on every microcontroller:
+ * @code
+ * cowpi_set_output_pins(COWPI_PIN_SET(LEFT_LED) | COWPI_PIN_SET(RIGHT_LED));
+ * @endcode
+ *
+ ******************************************************************************/
+
+/* CowPi (c) 2021-24 Christopher A. Bohn
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COWPI_PIN_SET_H
+#define COWPI_PIN_SET_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined (ARDUINO_AVR_MEGA2560)
+typedef uint64_t cowpi_pin_set_t;       //!< Bit vector with one bit per pin
+#else
+typedef uint32_t cowpi_pin_set_t;       //!< Bit vector with one bit per pin
+#endif //ARDUINO_AVR_MEGA2560
+
+#define COWPI_PIN_SET_WIDTH (8 * sizeof(cowpi_pin_set_t))       //!< Number of pins that a `cowpi_pin_set_t` can represent
+#define COWPI_PIN_SET(pin)  (((cowpi_pin_set_t) 1) << (pin))    //!< The pin set containing only the specified pin
+
+#ifdef __cplusplus
+} // extern "C"
+
+namespace cowpi {
+
+/**
+ * @brief The empty pin set.
+ */
+constexpr cowpi_pin_set_t pin_set() {
+    return 0;
+}
+
+/**
+ * @brief The pin set containing each of the specified pins.
+ *
+ * For example, `cowpi::pin_set(LEFT_LED, RIGHT_LED)`.
+ */
+template <typename... PINS>
+constexpr cowpi_pin_set_t pin_set(uint8_t pin, PINS... pins) {
+    return COWPI_PIN_SET(pin) | pin_set(pins...);
+}
+
+} // namespace cowpi
+
+#endif //__cplusplus
+
+#endif //COWPI_PIN_SET_H